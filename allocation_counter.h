@@ -0,0 +1,16 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Debug aid for keeping the simulation step free of heap allocations. Built
+// with COUNT_ALLOCATIONS defined (make DEBUG_ALLOCATIONS=1), the global
+// operator new counts every allocation in the process and
+// Network::update_with_learning() asserts that a step made none. Without it
+// nothing is replaced and the count stays 0.
+//
+// The count covers all threads, so the check assumes no other thread
+// allocates while a step runs.
+uint64_t heap_allocation_count();
+
+#endif // ALLOCATION_COUNTER_H
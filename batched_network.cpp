@@ -0,0 +1,76 @@
+#include "batched_network.h"
+#include <algorithm>
+
+BatchedNetwork::BatchedNetwork(const Network& network, size_t batch_size) {
+    const NeuronState& state = network.get_state();
+    const SynapseStore& synapses = network.get_synapses();
+    num_neurons = state.size();
+    batch = std::min(MAX_BATCH_SIZE, std::max((size_t)8, (batch_size + 7) / 8 * 8));
+
+    const size_t lanes = num_neurons * batch;
+    threshold.resize(lanes);
+    resting.resize(lanes);
+    decay.resize(lanes);
+    for (size_t i = 0; i < num_neurons; ++i) {
+        std::fill(threshold.begin() + i * batch, threshold.begin() + (i + 1) * batch, state.threshold[i]);
+        std::fill(resting.begin() + i * batch, resting.begin() + (i + 1) * batch, state.resting_potential[i]);
+        std::fill(decay.begin() + i * batch, decay.begin() + (i + 1) * batch, state.decay_factor[i]);
+    }
+    potential = resting;
+    has_spiked.assign(lanes, 0);
+    spike_count.assign(lanes, 0);
+
+    const uint32_t* source_offsets = synapses.offsets_data();
+    const size_t total = source_offsets[num_neurons];
+    offsets.assign(source_offsets, source_offsets + num_neurons + 1);
+    targets.assign(synapses.targets_data(), synapses.targets_data() + total);
+    weights.assign(synapses.weights_data(), synapses.weights_data() + total);
+    synapses.sweep_chunks(sweep_chunks);
+
+    lane_spikes.resize(lanes);
+    set_simd_level(network.get_simd_level());
+}
+
+void BatchedNetwork::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    fire_kernel = select_fire_kernel(level);
+    accumulate_kernel = select_batch_accumulate_kernel(level);
+}
+
+void BatchedNetwork::reset() {
+    potential = resting;
+    std::fill(has_spiked.begin(), has_spiked.end(), 0);
+    std::fill(spike_count.begin(), spike_count.end(), 0);
+}
+
+void BatchedNetwork::update() {
+    // Chunked sweep of Network::step() across all lanes: fire a chunk of
+    // neurons in every lane, then deliver each spiking neuron's row once to
+    // all of its spiking lanes, in ascending neuron order
+    uint32_t* spikes = lane_spikes.data();
+    for (size_t c = 0; c + 1 < sweep_chunks.size(); ++c) {
+        const size_t begin = sweep_chunks[c] * batch;
+        const size_t count = sweep_chunks[c + 1] * batch - begin;
+        const size_t fired = fire_kernel(potential.data() + begin, threshold.data() + begin,
+                                         resting.data() + begin, decay.data() + begin,
+                                         has_spiked.data() + begin, count,
+                                         (uint32_t)begin, spikes);
+
+        // Spike indices are ascending, so the lanes of one neuron are adjacent
+        size_t s = 0;
+        while (s < fired) {
+            const uint32_t i = spikes[s] / batch;
+            const uint32_t lanes_end = (i + 1) * batch;
+            while (s < fired && spikes[s] < lanes_end) {
+                spike_count[spikes[s]]++;
+                ++s;
+            }
+            accumulate_kernel(potential.data(), targets.data() + offsets[i],
+                              weights.data() + offsets[i], offsets[i + 1] - offsets[i],
+                              has_spiked.data() + (size_t)i * batch, batch);
+        }
+    }
+}
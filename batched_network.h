@@ -0,0 +1,75 @@
+#ifndef BATCHED_NETWORK_H
+#define BATCHED_NETWORK_H
+
+#include "network.h"
+#include "simd_kernels.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Inference-only snapshot of a Network that simulates a batch of independent
+// inputs at once. Every neuron has one lane per batch entry, stored next to
+// each other (lane b of neuron i at index i * batch_size() + b), so the fire
+// kernel runs across the whole batch and each synaptic weight is loaded once
+// and added to all lanes whose source spiked. Each lane follows the
+// time-driven engine exactly, so lane b gives the same spikes as running
+// Network::update() on input b alone (like CompiledNetwork, every synapse
+// is treated as having delay 1).
+class BatchedNetwork {
+public:
+    // Copy the topology, weights and neuron parameters of network. The batch
+    // size is rounded up to a multiple of 8 and capped at MAX_BATCH_SIZE.
+    BatchedNetwork(const Network& network, size_t batch_size);
+
+    // Get number of neurons
+    size_t size() const { return num_neurons; }
+
+    // Number of lanes (inputs simulated together)
+    size_t batch_size() const { return batch; }
+
+    // Instruction set for the kernels (defaults to the best available)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset every lane to the resting state
+    void reset();
+
+    // Apply external input current to neuron i in the given lane
+    void apply_input(size_t lane, size_t i, double current) {
+        potential[i * batch + lane] += current;
+    }
+
+    // Advance every lane by one time step
+    void update();
+
+    // Per-lane spike and potential accessors
+    bool spiked(size_t lane, size_t i) const { return has_spiked[i * batch + lane] != 0; }
+    int get_spike_count(size_t lane, size_t i) const { return spike_count[i * batch + lane]; }
+    double get_potential(size_t lane, size_t i) const { return potential[i * batch + lane]; }
+
+private:
+    size_t num_neurons;
+    size_t batch;
+
+    // Per-lane state; the parameters are replicated per lane so the regular
+    // fire kernel can sweep a chunk of neurons across all lanes at once
+    std::vector<double> potential;
+    std::vector<double> threshold;
+    std::vector<double> resting;
+    std::vector<double> decay;
+    std::vector<unsigned char> has_spiked;
+    std::vector<int> spike_count;
+
+    // CSR synapses and the chunks the sweep fires at once
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<double> weights;
+    std::vector<uint32_t> sweep_chunks;
+
+    std::vector<uint32_t> lane_spikes;  // Spiking (neuron * batch + lane) indices
+    SimdLevel simd_level;
+    FireKernel fire_kernel;
+    BatchAccumulateKernel accumulate_kernel;
+};
+
+#endif // BATCHED_NETWORK_H
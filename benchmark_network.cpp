@@ -0,0 +1,231 @@
+#include "network.h"
+#include "compiled_network.h"
+#include "quantized_network.h"
+#include "batched_network.h"
+#include "static_network.h"
+#include "load_mnist.cpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <algorithm>
+
+// Engine benchmark: times the simulation engines on the MNIST architectures
+// used by train_mnist and reports the parallel speedup over the serial path.
+
+struct BenchmarkArchitecture {
+    std::string name;
+    std::vector<int> layers;  // input, hidden..., output
+
+    int total_neurons() const {
+        int total = 0;
+        for (int size : layers) total += size;
+        return total;
+    }
+};
+
+struct EngineConfig {
+    std::string name;
+    SimulationMode mode;
+    size_t threads;
+    SimdLevel simd;
+};
+
+// Fully connect consecutive layers with a fixed seed so every run is identical
+void build_layers(Network& network, const BenchmarkArchitecture& arch) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> weight_dist(0.05, 0.15);
+    int layer_start = 0;
+    for (size_t layer = 0; layer + 1 < arch.layers.size(); ++layer) {
+        int next_start = layer_start + arch.layers[layer];
+        network.connect_dense(layer_start, next_start, next_start,
+                              next_start + arch.layers[layer + 1],
+                              [&](size_t, size_t) { return weight_dist(gen); });
+        layer_start = next_start;
+    }
+}
+
+// Present every sample for simulation_steps steps; returns milliseconds per sample
+// (inference-only snapshots: CompiledNetwork and QuantizedNetwork)
+template <typename Snapshot>
+double time_snapshot_samples(Snapshot& network, const std::vector<MNISTLoader::Sample>& samples,
+                             int input_size, int simulation_steps) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& sample : samples) {
+        network.reset();
+        for (size_t i = 0; i < sample.data.size() && i < (size_t)input_size; ++i) {
+            network.apply_input(i, sample.data[i] * 2.0);
+        }
+        for (int step = 0; step < simulation_steps; ++step) {
+            network.update();
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / samples.size();
+}
+
+// Times the StaticNetwork specialization picked by with_static_network()
+struct StaticTimer {
+    const std::vector<MNISTLoader::Sample>& samples;
+    int input_size;
+    int simulation_steps;
+    double milliseconds;
+
+    template <typename Snapshot>
+    void operator()(Snapshot& network) {
+        milliseconds = time_snapshot_samples(network, samples, input_size, simulation_steps);
+    }
+};
+
+// Same, with batch_size() samples simulated at once
+double time_batched_samples(BatchedNetwork& network, const std::vector<MNISTLoader::Sample>& samples,
+                            int input_size, int simulation_steps) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < samples.size(); begin += network.batch_size()) {
+        size_t count = std::min(network.batch_size(), samples.size() - begin);
+        network.reset();
+        for (size_t lane = 0; lane < count; ++lane) {
+            const auto& sample = samples[begin + lane];
+            for (size_t i = 0; i < sample.data.size() && i < (size_t)input_size; ++i) {
+                network.apply_input(lane, i, sample.data[i] * 2.0);
+            }
+        }
+        for (int step = 0; step < simulation_steps; ++step) {
+            network.update();
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / samples.size();
+}
+
+double time_samples(Network& network, const std::vector<MNISTLoader::Sample>& samples,
+                    int input_size, int simulation_steps, bool learn) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& sample : samples) {
+        network.reset();
+        for (size_t i = 0; i < sample.data.size() && i < (size_t)input_size; ++i) {
+            network.get_neuron(i)->apply_input(sample.data[i] * 2.0);
+        }
+        for (int step = 0; step < simulation_steps; ++step) {
+            if (learn) {
+                network.update_with_learning(step, 0.01);
+            } else {
+                network.update();
+            }
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / samples.size();
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "=== Spike Network Engine Benchmark ===\n\n";
+
+    size_t threads = std::thread::hardware_concurrency();
+    int num_samples = 20;
+    int simulation_steps = 30;
+
+    if (argc > 1) threads = std::stoul(argv[1]);
+    if (argc > 2) num_samples = std::stoi(argv[2]);
+    if (argc > 3) simulation_steps = std::stoi(argv[3]);
+    if (threads < 1) threads = 1;
+
+    std::vector<BenchmarkArchitecture> architectures = {
+        {"medium", {784, 400, 200, 10}},
+        {"complex", {784, 512, 256, 128, 10}}
+    };
+
+    const SimdLevel simd = detect_simd_level();
+    std::vector<EngineConfig> configs = {
+        {"two-phase", SimulationMode::TwoPhase, 1, simd},
+        {"two-phase x" + std::to_string(threads), SimulationMode::TwoPhase, threads, simd},
+        {"time-driven", SimulationMode::TimeDriven, 1, simd},
+        {"time-driven scalar", SimulationMode::TimeDriven, 1, SimdLevel::Scalar},
+        {"event-driven", SimulationMode::EventDriven, 1, simd}
+    };
+
+    std::vector<MNISTLoader::Sample> samples = MNISTLoader::generate_synthetic_mnist(1);
+    while ((int)samples.size() < num_samples) {
+        samples.push_back(samples[samples.size() % 10]);
+    }
+    samples.resize(num_samples);
+
+    std::cout << "Samples: " << num_samples << ", steps per sample: " << simulation_steps
+              << ", threads: " << threads << ", SIMD: " << simd_level_name(simd) << "\n";
+    std::cout << "Speedup is relative to the serial two-phase engine.\n\n";
+
+    for (const auto& arch : architectures) {
+        std::cout << "Architecture: " << arch.name << " (" << arch.total_neurons() << " neurons)\n";
+        std::cout << "Engine            | Inference ms/sample | Speedup | Training ms/sample | Speedup\n";
+        std::cout << "------------------|---------------------|---------|--------------------|--------\n";
+
+        double serial_inference = 0.0;
+        double serial_training = 0.0;
+        for (const auto& config : configs) {
+            // Fresh network per configuration so training starts from the same weights
+            Network network(arch.total_neurons());
+            build_layers(network, arch);
+            network.get_synapses().compact();  // Keep the one-off CSR build out of the timings
+            network.set_simulation_mode(config.mode);
+            network.set_num_threads(config.threads);
+            network.set_simd_level(config.simd);
+
+            double inference = time_samples(network, samples, arch.layers[0], simulation_steps, false);
+            double training = time_samples(network, samples, arch.layers[0], simulation_steps, true);
+            if (serial_inference == 0.0) {
+                // First configuration is the serial two-phase baseline
+                serial_inference = inference;
+                serial_training = training;
+            }
+
+            std::cout << std::left << std::setw(18) << config.name << std::right << "| "
+                      << std::setw(19) << std::fixed << std::setprecision(3) << inference << " | "
+                      << std::setw(6) << std::setprecision(2) << serial_inference / inference << "x | "
+                      << std::setw(18) << std::setprecision(3) << training << " | "
+                      << std::setw(5) << std::setprecision(2) << serial_training / training << "x\n";
+        }
+
+        // Static, float, fixed-point and batched snapshots of the untrained
+        // network, and the other neuron models (inference only)
+        Network reference(arch.total_neurons());
+        build_layers(reference, arch);
+        std::vector<std::vector<double>> calibration_inputs;
+        for (const auto& sample : samples) {
+            std::vector<double> currents(arch.layers[0], 0.0);
+            for (size_t i = 0; i < sample.data.size() && i < currents.size(); ++i) {
+                currents[i] = sample.data[i] * 2.0;
+            }
+            calibration_inputs.push_back(currents);
+        }
+        FloatNetwork float_network(reference);
+        QuantizedNetwork fixed_network(reference,
+            QuantizedNetwork::calibrate(reference, calibration_inputs, simulation_steps));
+        double float_inference = time_snapshot_samples(float_network, samples, arch.layers[0], simulation_steps);
+        double fixed_inference = time_snapshot_samples(fixed_network, samples, arch.layers[0], simulation_steps);
+        BatchedNetwork batched_network(reference, 16);
+        double batched_inference = time_batched_samples(batched_network, samples, arch.layers[0], simulation_steps);
+        CompiledNetwork<float, RefractoryLIF> refractory_network(reference);
+        double refractory_inference = time_snapshot_samples(refractory_network, samples, arch.layers[0], simulation_steps);
+        CompiledNetwork<float, Izhikevich> izhikevich_network(reference);
+        double izhikevich_inference = time_snapshot_samples(izhikevich_network, samples, arch.layers[0], simulation_steps);
+        StaticTimer static_timer = {samples, arch.layers[0], simulation_steps, 0.0};
+        with_static_network(reference, static_timer);
+        const std::string snapshot_names[6] = {"static time-driven", "float time-driven", "fixed time-driven",
+                                               "batched x16", "float refractory", "float Izhikevich"};
+        const double snapshot_times[6] = {static_timer.milliseconds, float_inference, fixed_inference,
+                                          batched_inference, refractory_inference, izhikevich_inference};
+        for (int k = 0; k < 6; ++k) {
+            std::cout << std::left << std::setw(18) << snapshot_names[k] << std::right << "| "
+                      << std::setw(19) << std::fixed << std::setprecision(3) << snapshot_times[k] << " | "
+                      << std::setw(6) << std::setprecision(2) << serial_inference / snapshot_times[k] << "x | "
+                      << std::setw(18) << "-" << " | " << std::setw(6) << "-" << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "=== Benchmark Complete ===\n";
+    return 0;
+}
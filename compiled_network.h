@@ -0,0 +1,149 @@
+#ifndef COMPILED_NETWORK_H
+#define COMPILED_NETWORK_H
+
+#include "network.h"
+#include "simd_kernels.h"
+#include "neuron_models.h"
+#include "spike_delivery.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Inference-only snapshot of a Network with neuron state and synaptic weights
+// stored as Scalar. It runs the time-driven engine (same update order and
+// same-step delivery to higher-index targets as Network::update()), so
+// CompiledNetwork<double> reproduces the reference network exactly and
+// CompiledNetwork<float> halves the memory traffic for weights and doubles
+// the width of the vectorized fire kernel. Later changes to the source
+// network are not reflected; compile a new snapshot instead. Synaptic
+// delays are not modelled: every synapse delivers as if its delay were 1.
+// Copies share the synapses and get their own neuron state, so one copy per
+// thread can simulate different inputs concurrently.
+//
+// Model is the neuron model policy (see neuron_models.h). The default, LIF,
+// is the rule Network itself runs; RefractoryLIF and Izhikevich keep the
+// topology and weights but replace the neuron dynamics.
+template <typename Scalar, template <typename> class Model = LIF>
+class CompiledNetwork {
+public:
+    typedef Model<Scalar> NeuronModel;
+    typedef typename NeuronModel::Params ModelParams;
+
+    // Copy the topology, weights and neuron parameters of network
+    explicit CompiledNetwork(const Network& network, const ModelParams& params = ModelParams());
+
+    // Get number of neurons
+    size_t size() const { return has_spiked.size(); }
+
+    // Get total number of connections
+    size_t connection_count() const { return synapses->targets.size(); }
+
+    // Instruction set for the fire kernel (defaults to the best available)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset all neurons to their resting state
+    void reset();
+
+    // Apply external input current to neuron i
+    void apply_input(size_t i, double current) { NeuronModel::input(neurons)[i] += (Scalar)current; }
+
+    // Advance the network by one time step
+    void update();
+
+    // Spike and potential accessors
+    bool spiked(size_t i) const { return has_spiked[i] != 0; }
+    int get_spike_count(size_t i) const { return spike_count[i]; }
+    double get_potential(size_t i) const { return NeuronModel::potential(neurons, i); }
+
+    // Neurons that spiked in the last step, in ascending index order
+    const std::vector<uint32_t>& get_step_spikes() const { return step_spikes; }
+
+    // Bytes used by the synapse arrays (targets and weights)
+    size_t synapse_bytes() const {
+        return synapses->targets.size() * sizeof(uint32_t) + synapses->weights.size() * sizeof(Scalar);
+    }
+
+private:
+    typedef void (*Accumulate)(Scalar*, const Scalar*, size_t);
+
+    // Neuron state
+    typename NeuronModel::State neurons;
+    std::vector<unsigned char> has_spiked;
+    std::vector<int> spike_count;
+
+    // CSR synapses, the chunks the sweep fires at once and the dense blocks
+    std::shared_ptr<const SnapshotSynapses<Scalar>> synapses;
+
+    std::vector<uint32_t> step_spikes;
+    SimdLevel simd_level;
+    Accumulate accumulate_kernel;
+};
+
+typedef CompiledNetwork<float> FloatNetwork;
+
+template <typename Scalar, template <typename> class Model>
+CompiledNetwork<Scalar, Model>::CompiledNetwork(const Network& network, const ModelParams& params) {
+    const NeuronState& state = network.get_state();
+    const size_t n = state.size();
+
+    NeuronModel::init(neurons, state, params, n);
+    has_spiked.assign(n, 0);
+    spike_count.assign(n, 0);
+
+    synapses = std::make_shared<const SnapshotSynapses<Scalar>>(network.get_synapses(),
+        [](double weight) { return (Scalar)weight; });
+
+    step_spikes.reserve(n);
+    set_simd_level(network.get_simd_level());
+}
+
+template <typename Scalar, template <typename> class Model>
+void CompiledNetwork<Scalar, Model>::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    NeuronModel::select_kernels(neurons, level);
+    select_accumulate_kernel(level, accumulate_kernel);
+}
+
+template <typename Scalar, template <typename> class Model>
+void CompiledNetwork<Scalar, Model>::reset() {
+    NeuronModel::reset(neurons);
+    std::fill(has_spiked.begin(), has_spiked.end(), 0);
+    std::fill(spike_count.begin(), spike_count.end(), 0);
+    step_spikes.clear();
+}
+
+template <typename Scalar, template <typename> class Model>
+void CompiledNetwork<Scalar, Model>::update() {
+    // Same chunked sweep and dense block delivery as Network::step(), with
+    // the neuron model's step in place of the LIF fire kernel
+    step_spikes.resize(size());
+    Scalar* input = NeuronModel::input(neurons);
+    const Scalar* w = synapses->weights.data();
+    const SpikeRoutes routes = make_spike_routes(*synapses);
+    const Accumulate accumulate = accumulate_kernel;
+    typename NeuronModel::State& state = neurons;
+    unsigned char* spiked = has_spiked.data();
+    int* counts = spike_count.data();
+    step_spikes.resize(sweep_in_chunks(synapses->sweep_chunks, step_spikes.data(),
+        [&state, spiked](size_t begin, size_t count, uint32_t* out) {
+            return NeuronModel::fire(state, begin, count, spiked + begin, out);
+        },
+        [&routes, input, w, accumulate, counts](const uint32_t* spikes, size_t fired) {
+            for (size_t s = 0; s < fired; ++s) {
+                counts[spikes[s]]++;
+            }
+            route_spikes(routes, spikes, fired,
+                [input, w](uint32_t target, uint32_t slot) { input[target] += w[slot]; },
+                [input, w, accumulate](size_t target, size_t slot, size_t length) {
+                    accumulate(input + target, w + slot, length);
+                });
+        }));
+}
+
+#endif // COMPILED_NETWORK_H
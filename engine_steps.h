@@ -0,0 +1,181 @@
+#ifndef ENGINE_STEPS_H
+#define ENGINE_STEPS_H
+
+#include "spike_delivery.h"
+#include "synapse_store.h"
+#include "simd_kernels.h"
+#include "stdp_kernel.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// The double-precision engines, written once. Network, SimulationState and
+// LearningState keep their own neuron state and weights but all step through
+// these functions, so a change to an engine lands in every class at once.
+// Delivery is a callback, since a LearningState reads the shared weights
+// atomically while the others add them directly (see deliver_weights()).
+
+// Neuron state one step runs over: size neurons, parameters read-only
+struct EngineNeurons {
+    double* potential;
+    const double* threshold;
+    const double* resting;
+    const double* decay;
+    unsigned char* spiked;
+    int* spike_count;
+    size_t size;
+};
+
+// Synaptic input waiting for a later step: slots rows of one input per
+// neuron, the row of step s at s % slots. slots is 0 when no synapse has a
+// delay above 1, and step is the step about to run.
+struct EngineDelays {
+    double* ring;
+    size_t slots;
+    int step;
+};
+
+// Add the delay-1 weights of spikes[0, count) (ascending) to input, dense
+// blocks through the accumulate kernel
+inline void deliver_weights(const SpikeRoutes& routes, const double* weights,
+                            AccumulateKernel accumulate, const uint32_t* spikes, size_t count,
+                            double* input) {
+    route_spikes(routes, spikes, count,
+        [input, weights](uint32_t target, uint32_t slot) { input[target] += weights[slot]; },
+        [input, weights, accumulate](size_t target, size_t slot, size_t length) {
+            accumulate(input + target, weights + slot, length);
+        });
+}
+
+// Queue the delay > 1 weights of spikes[0, count), fired in delays.step, in
+// the ring of n neurons (see delayed_due() for sweep_order)
+inline void queue_delayed_spikes(const SpikeRoutes& routes, const double* weights,
+                                 const EngineDelays& delays, size_t n,
+                                 const uint32_t* spikes, size_t count, bool sweep_order) {
+    double* ring = delays.ring;
+    const size_t slots = delays.slots;
+    route_delayed_spikes(routes, spikes, count, delays.step, sweep_order,
+        [weights, ring, slots, n](uint32_t target, uint32_t slot, int due) {
+            ring[((size_t)due % slots) * n + target] += weights[slot];
+        });
+}
+
+// Threshold, reset and decay for neurons [begin, begin + count): spikes go
+// to out (ascending) and are counted. Returns how many.
+inline size_t fire_neurons(const EngineNeurons& neurons, FireKernel fire, size_t begin,
+                           size_t count, uint32_t* out) {
+    const size_t fired = fire(neurons.potential + begin, neurons.threshold + begin,
+                              neurons.resting + begin, neurons.decay + begin,
+                              neurons.spiked + begin, count, (uint32_t)begin, out);
+    for (size_t s = 0; s < fired; ++s) {
+        neurons.spike_count[out[s]]++;
+    }
+    return fired;
+}
+
+// One time-driven step. Spikes are delivered immediately, so a target with a
+// higher index sees the input in this same step. Each chunk of chunks (see
+// SynapseStore::sweep_chunks()) is fired with the vectorized kernel first
+// and its spikes delivered afterwards, in index order; since no neuron in a
+// chunk feeds a later neuron of the same chunk, this gives exactly the same
+// result as updating neuron by neuron. deliver(spikes, count, input) adds
+// the delay-1 weights; longer delays are queued from weights. The spikes go
+// to spikes (room for every neuron); returns how many.
+template <typename Deliver>
+inline size_t time_driven_step(const EngineNeurons& neurons, FireKernel fire,
+                               const std::vector<uint32_t>& chunks, const SpikeRoutes& routes,
+                               const double* weights, const EngineDelays& delays,
+                               uint32_t* spikes, Deliver deliver) {
+    if (delays.slots > 0) {
+        apply_delay_slot(neurons.potential, delays.ring, delays.slots, delays.step, neurons.size);
+    }
+    return sweep_in_chunks(chunks, spikes,
+        [&neurons, fire](size_t begin, size_t count, uint32_t* out) {
+            return fire_neurons(neurons, fire, begin, count, out);
+        },
+        [&](const uint32_t* fired_spikes, size_t fired) {
+            deliver(fired_spikes, fired, neurons.potential);
+            if (delays.slots > 0) {
+                queue_delayed_spikes(routes, weights, delays, neurons.size, fired_spikes, fired,
+                                     true);
+            }
+        });
+}
+
+// One two-phase step. Phase 1 only reads and writes each neuron's own state
+// and phase 2 only writes input (zero on entry and exit), so the outcome
+// does not depend on the order neurons are visited in. Every spike reaches
+// its targets in the next step. Arguments as time_driven_step().
+template <typename Deliver>
+inline size_t two_phase_step(const EngineNeurons& neurons, FireKernel fire,
+                             const SpikeRoutes& routes, const double* weights,
+                             const EngineDelays& delays, double* input, uint32_t* spikes,
+                             Deliver deliver) {
+    const size_t n = neurons.size;
+    if (delays.slots > 0) {
+        apply_delay_slot(neurons.potential, delays.ring, delays.slots, delays.step, n);
+    }
+
+    // Phase 1: threshold, reset and decay
+    const size_t fired = fire_neurons(neurons, fire, 0, n, spikes);
+
+    // Phase 2: accumulate synaptic input, then apply it
+    deliver(spikes, fired, input);
+    if (delays.slots > 0) {
+        queue_delayed_spikes(routes, weights, delays, n, spikes, fired, false);
+    }
+    double* potential = neurons.potential;
+    for (size_t i = 0; i < n; ++i) {
+        potential[i] += input[i];
+        input[i] = 0.0;
+    }
+    return fired;
+}
+
+// Trace-based STDP of update_with_learning(), for neuron i (j) that spiked
+// at time t: depress every outgoing synapse i -> j whose target spiked
+// before, potentiate every incoming synapse h -> j whose source spiked
+// before, clamping to [0, 1]. Weights go through read(slot) and
+// write(slot, weight), so a caller can keep them anywhere.
+template <typename Read, typename Write>
+inline void stdp_depress_row(const SynapseStore& synapses, const StdpKernel& kernel,
+                             const int* last_spike_time, uint32_t i, int t,
+                             Read read, Write write) {
+    const uint32_t* targets = synapses.targets_data();
+    for (uint32_t k = synapses.row_begin(i); k < synapses.row_end(i); ++k) {
+        const int post_spike_time = last_spike_time[targets[k]];
+        if (post_spike_time < 0) continue; // Post-synaptic neuron hasn't spiked
+
+        // Post before pre: Long-Term Depression (LTD)
+        const int dt = t - post_spike_time;
+        if (dt > 0) {
+            double weight = read(k) - kernel.depression(dt);
+            if (weight < 0.0) weight = 0.0;
+            write(k, weight);
+        }
+    }
+}
+
+template <typename Read, typename Write>
+inline void stdp_potentiate_column(const SynapseStore& synapses, const StdpKernel& kernel,
+                                   const int* last_spike_time, uint32_t j, int t,
+                                   Read read, Write write) {
+    const uint32_t* incoming_offsets = synapses.incoming_offsets_data();
+    const uint32_t* incoming_slots = synapses.incoming_slots_data();
+    const uint32_t* incoming_sources = synapses.incoming_sources_data();
+    for (uint32_t c = incoming_offsets[j]; c < incoming_offsets[j + 1]; ++c) {
+        const int pre_spike_time = last_spike_time[incoming_sources[c]];
+        if (pre_spike_time < 0) continue; // Pre-synaptic neuron hasn't spiked
+
+        // Pre before post: Long-Term Potentiation (LTP)
+        const int dt = t - pre_spike_time;
+        if (dt > 0) {
+            const uint32_t slot = incoming_slots[c];
+            double weight = read(slot) + kernel.potentiation(dt);
+            if (weight > 1.0) weight = 1.0;
+            write(slot, weight);
+        }
+    }
+}
+
+#endif // ENGINE_STEPS_H
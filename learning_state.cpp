@@ -0,0 +1,180 @@
+#include "learning_state.h"
+#include "engine_steps.h"
+#include <algorithm>
+
+// Shared weights are read and written with relaxed atomics: a value is never
+// torn, but nothing orders the updates of different workers (see the class
+// comment). On x86-64 these are plain loads and stores.
+static inline double load_weight(const double* weight) {
+    double value;
+    __atomic_load(weight, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+static inline void store_weight(double* weight, double value) {
+    __atomic_store(weight, &value, __ATOMIC_RELAXED);
+}
+
+LearningState::LearningState(Network& network)
+    : params(network.state), synapses(network.synapses),
+      weights(network.synapses.weights_data()), deferred(false) {
+    const size_t n = network.size();
+    synapses.sweep_chunks(sweep_chunks);
+    synapses.dense_blocks(dense_blocks, dense_block_of_row);
+    synapses.incoming_offsets_data();  // Build the reverse index before workers read it
+
+    potential = params.resting_potential;
+    has_spiked.assign(n, 0);
+    spike_count.assign(n, 0);
+    last_spike_time.assign(n, -1);
+    step_spikes.reserve(n);
+    set_simd_level(detect_simd_level());
+}
+
+void LearningState::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    fire_kernel = select_fire_kernel(level);
+    accumulate_kernel = select_accumulate_kernel(level);
+}
+
+void LearningState::set_deferred(bool enabled) {
+    deferred = enabled;
+    if (enabled) {
+        const size_t total = synapses.size();
+        delta.assign(total, 0.0);
+        delta_touched.assign((total + DELTA_TILE_SLOTS - 1) / DELTA_TILE_SLOTS, 0);
+    } else {
+        std::vector<double>().swap(delta);
+        std::vector<unsigned char>().swap(delta_touched);
+    }
+}
+
+void LearningState::merge_deferred(LearningState* const* learners, size_t count, ThreadPool* pool) {
+    if (count == 0) return;
+    double* weights = learners[0]->weights;
+    const size_t total = learners[0]->delta.size();
+    const size_t tiles = learners[0]->delta_touched.size();
+    auto merge = [&](size_t worker) {
+        size_t begin = 0, end = tiles;
+        if (pool) ThreadPool::partition(tiles, pool->size(), worker, begin, end);
+        for (size_t tile = begin; tile < end; ++tile) {
+            const size_t first = tile * DELTA_TILE_SLOTS;
+            const size_t last = std::min(total, first + DELTA_TILE_SLOTS);
+            bool touched = false;
+            for (size_t l = 0; l < count; ++l) {
+                LearningState& learner = *learners[l];
+                if (!learner.delta_touched[tile]) continue;
+                learner.delta_touched[tile] = 0;
+                touched = true;
+                for (size_t k = first; k < last; ++k) {
+                    weights[k] += learner.delta[k];
+                    learner.delta[k] = 0.0;
+                }
+            }
+            if (!touched) continue;
+            for (size_t k = first; k < last; ++k) {
+                if (weights[k] < 0.0) weights[k] = 0.0;
+                if (weights[k] > 1.0) weights[k] = 1.0;
+            }
+        }
+    };
+    if (pool) {
+        pool->run(merge);
+    } else {
+        merge(0);
+    }
+}
+
+void LearningState::reset() {
+    potential = params.resting_potential;
+    std::fill(has_spiked.begin(), has_spiked.end(), 0);
+    std::fill(spike_count.begin(), spike_count.end(), 0);
+    std::fill(last_spike_time.begin(), last_spike_time.end(), -1);
+    step_spikes.clear();
+}
+
+void LearningState::update_with_learning(int time_step, double learning_rate) {
+    step();
+
+    // Same order as Network: depress the rows of this step's spikes, then
+    // potentiate their columns, then record the spike times
+    if (!stdp_kernel.matches(learning_rate, STDP_TAU_PLUS, STDP_TAU_MINUS)) {
+        stdp_kernel.configure(learning_rate, STDP_TAU_PLUS, STDP_TAU_MINUS);
+    }
+    for (uint32_t i : step_spikes) {
+        depress_row(i, time_step);
+    }
+    for (uint32_t j : step_spikes) {
+        potentiate_column(j, time_step);
+    }
+    for (uint32_t i : step_spikes) {
+        last_spike_time[i] = time_step;
+    }
+}
+
+void LearningState::step() {
+    // The time-driven engine of engine_steps.h, without delays
+    const SpikeRoutes routes = make_spike_routes(synapses, dense_blocks, dense_block_of_row);
+    const EngineNeurons neurons = {potential.data(), params.threshold.data(),
+                                   params.resting_potential.data(), params.decay_factor.data(),
+                                   has_spiked.data(), spike_count.data(), size()};
+    const EngineDelays delays = {nullptr, 0, 0};
+    step_spikes.resize(size());
+    step_spikes.resize(time_driven_step(neurons, fire_kernel, sweep_chunks, routes, weights, delays,
+                                        step_spikes.data(),
+        [this](const uint32_t* spikes, size_t count, double*) { deliver_spikes(spikes, count); }));
+}
+
+void LearningState::deliver_spikes(const uint32_t* spikes, size_t count) {
+    // Other workers store into the shared weights while this one reads
+    // them, so every read is a relaxed atomic load. In deferred mode nobody
+    // writes them until the merge, and dense blocks use the vector kernel.
+    SpikeRoutes routes = make_spike_routes(synapses, dense_blocks, dense_block_of_row);
+    routes.delays = nullptr;  // Every synapse delivers as delay 1
+    const double* w = weights;
+    double* v = potential.data();
+    auto add = [v, w](uint32_t target, uint32_t slot) { v[target] += load_weight(w + slot); };
+    if (deferred) {
+        const AccumulateKernel accumulate = accumulate_kernel;
+        route_spikes(routes, spikes, count, add,
+            [v, w, accumulate](size_t target, size_t slot, size_t length) {
+                accumulate(v + target, w + slot, length);
+            });
+    } else {
+        route_spikes(routes, spikes, count, add,
+            [v, w](size_t target, size_t slot, size_t length) {
+                for (size_t k = 0; k < length; ++k) {
+                    v[target + k] += load_weight(w + slot + k);
+                }
+            });
+    }
+}
+
+double LearningState::read_weight(uint32_t slot) const {
+    // No worker writes the shared weights in deferred mode
+    return deferred ? weights[slot] + delta[slot] : load_weight(weights + slot);
+}
+
+void LearningState::write_weight(uint32_t slot, double weight) {
+    if (deferred) {
+        delta[slot] = weight - weights[slot];
+        delta_touched[slot / DELTA_TILE_SLOTS] = 1;
+    } else {
+        store_weight(weights + slot, weight);
+    }
+}
+
+void LearningState::depress_row(uint32_t i, int t) {
+    stdp_depress_row(synapses, stdp_kernel, last_spike_time.data(), i, t,
+                     [this](uint32_t slot) { return read_weight(slot); },
+                     [this](uint32_t slot, double weight) { write_weight(slot, weight); });
+}
+
+void LearningState::potentiate_column(uint32_t j, int t) {
+    stdp_potentiate_column(synapses, stdp_kernel, last_spike_time.data(), j, t,
+                           [this](uint32_t slot) { return read_weight(slot); },
+                           [this](uint32_t slot, double weight) { write_weight(slot, weight); });
+}
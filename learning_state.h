@@ -0,0 +1,133 @@
+#ifndef LEARNING_STATE_H
+#define LEARNING_STATE_H
+
+#include "network.h"
+#include "stdp_kernel.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Synapses per tile of a deferred delta buffer (64 bytes of deltas)
+const size_t DELTA_TILE_SLOTS = 8;
+
+// One worker of data-parallel (Hogwild) STDP training. Each worker presents
+// its own samples with its own neuron state -- potentials, spike flags and
+// counts, last spike times -- while the weights stay in the Network and are
+// shared by every worker: spikes are delivered straight from them and STDP
+// writes into them in place.
+//
+// A weight update is a relaxed atomic load, the change, and a relaxed atomic
+// store. Nothing is locked, so when two workers update the same synapse at
+// once one of the changes can be lost, and delivery may see a weight from
+// just before or just after another worker's update. That is the Hogwild
+// trade: STDP changes are small and rarely collide, and training runs
+// without synchronization. With a single worker the result is bit-identical
+// to Network::update_with_learning() on the time-driven engine.
+//
+// Deferred mode is the reproducible alternative: a worker leaves the shared
+// weights alone and collects its changes in a private delta buffer, which
+// merge_deferred() folds into the weights between rounds of samples. During
+// a round every worker delivers spikes through the weights as of the last
+// merge (its own changes included only after it), much like a mini-batch,
+// and nothing is shared for writing, so there is no race and no false
+// sharing. The merge adds the buffers in worker order, so results depend only
+// on the samples each worker was given.
+//
+// The network's neuron parameters and topology must not change while
+// workers run (connect()/disconnect() would move the weights), and the
+// Network itself must not be stepped at the same time. Like the inference
+// snapshots, a LearningState treats every synapse as delay 1.
+class LearningState {
+public:
+    // Start at rest on network, whose weights this state trains
+    explicit LearningState(Network& network);
+
+    // Get number of neurons
+    size_t size() const { return potential.size(); }
+
+    // Instruction set for the fire and accumulate kernels (defaults to the
+    // best available; every level gives the same spikes)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset all neurons to their resting state and forget their spike times
+    void reset();
+
+    // Apply external input current to neuron i
+    void apply_input(size_t i, double current) { potential[i] += current; }
+
+    // One time-driven step followed by trace-based STDP on the shared
+    // weights, as Network::update_with_learning()
+    void update_with_learning(int time_step, double learning_rate = 0.01);
+
+    // Collect weight changes in a private buffer instead of writing them to
+    // the shared weights (allocates one delta per synapse; off by default)
+    void set_deferred(bool enabled);
+    bool is_deferred() const { return deferred; }
+
+    // Add the deferred changes of learners[0, count) to the shared weights,
+    // learner by learner for every synapse, clamp the touched weights to
+    // [0, 1] and clear the buffers. The synapses are split between the
+    // workers of pool (may be null) in whole tiles; the result does not
+    // depend on the pool size. The learners must share one network and must
+    // not be running.
+    static void merge_deferred(LearningState* const* learners, size_t count, ThreadPool* pool);
+
+    // Spike accessors
+    bool spiked(size_t i) const { return has_spiked[i] != 0; }
+    int get_spike_count(size_t i) const { return spike_count[i]; }
+
+    // Neurons that spiked in the last step, in ascending index order
+    const std::vector<uint32_t>& get_step_spikes() const { return step_spikes; }
+
+private:
+    // One time-driven sweep, as Network::step()
+    void step();
+
+    // Add the outgoing weights of spikes[0, count) (ascending) to the potentials
+    void deliver_spikes(const uint32_t* spikes, size_t count);
+
+    // Weight of a synapse as this worker sees it, and its update: the shared
+    // weight itself, or in deferred mode the weight as of the last merge
+    // plus this worker's changes since
+    double read_weight(uint32_t slot) const;
+    void write_weight(uint32_t slot, double weight);
+
+    // STDP for the spikes of the step at time t, as Network::apply_stdp()
+    void depress_row(uint32_t i, int t);
+    void potentiate_column(uint32_t j, int t);
+
+    // Parameters and synapses of the network (not owned)
+    const NeuronState& params;
+    const SynapseStore& synapses;
+    double* weights;
+
+    // Topology derived data, as in Network
+    std::vector<uint32_t> sweep_chunks;
+    std::vector<DenseBlock> dense_blocks;
+    std::vector<int32_t> dense_block_of_row;
+
+    // Per-worker neuron state
+    std::vector<double> potential;
+    std::vector<unsigned char> has_spiked;
+    std::vector<int> spike_count;
+    std::vector<int> last_spike_time;
+    std::vector<uint32_t> step_spikes;
+
+    // Deferred changes: delta[slot] is added to weight slot at the next
+    // merge. delta_touched flags the tiles of DELTA_TILE_SLOTS consecutive
+    // synapses that hold any, so a merge skips
+    // the rest.
+    bool deferred;
+    std::vector<double> delta;
+    std::vector<unsigned char> delta_touched;
+
+    StdpKernel stdp_kernel;
+    SimdLevel simd_level;
+    FireKernel fire_kernel;
+    AccumulateKernel accumulate_kernel;
+};
+
+#endif // LEARNING_STATE_H
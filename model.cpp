@@ -0,0 +1,100 @@
+#include "model.h"
+#include "engine_steps.h"
+#include <algorithm>
+
+Model::Model(const Network& network)
+    : synapses(network.get_synapses(), [](double weight) { return weight; }),
+      longest_delay(network.get_synapses().max_delay()) {
+    const NeuronState& state = network.get_state();
+    threshold = state.threshold;
+    resting = state.resting_potential;
+    decay = state.decay_factor;
+    if (longest_delay > 1) {
+        const uint8_t* source = network.get_synapses().delays_data();
+        delays.assign(source, source + synapses.targets.size());
+    }
+}
+
+size_t Model::model_bytes() const {
+    return 3 * size() * sizeof(double) +
+           synapses.offsets.size() * sizeof(uint32_t) +
+           synapses.targets.size() * (sizeof(uint32_t) + sizeof(double)) +
+           synapses.sweep_chunks.size() * sizeof(uint32_t) +
+           synapses.dense_blocks.size() * sizeof(DenseBlock) +
+           synapses.dense_block_of_row.size() * sizeof(int32_t) +
+           delays.size() * sizeof(uint8_t);
+}
+
+SimulationState::SimulationState(std::shared_ptr<const Model> shared_model)
+    : model(shared_model), mode(SimulationMode::TimeDriven), sim_step(0),
+      potential(shared_model->resting), delay_slots(0) {
+    const size_t n = size();
+    has_spiked.assign(n, 0);
+    spike_count.assign(n, 0);
+    step_spikes.reserve(n);
+    if (model->max_delay() > 1) {
+        delay_slots = (size_t)model->max_delay() + 1;
+        delay_ring.assign(delay_slots * n, 0.0);
+    }
+    set_simd_level(detect_simd_level());
+}
+
+void SimulationState::set_simulation_mode(SimulationMode new_mode) {
+    mode = new_mode;
+    if (mode == SimulationMode::TwoPhase) {
+        input_buffer.assign(size(), 0.0);
+    } else {
+        std::vector<double>().swap(input_buffer);
+    }
+}
+
+void SimulationState::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    fire_kernel = select_fire_kernel(level);
+    accumulate_kernel = select_accumulate_kernel(level);
+}
+
+void SimulationState::reset() {
+    potential = model->resting;
+    std::fill(has_spiked.begin(), has_spiked.end(), 0);
+    std::fill(spike_count.begin(), spike_count.end(), 0);
+    step_spikes.clear();
+    std::fill(delay_ring.begin(), delay_ring.end(), 0.0);
+    sim_step = 0;
+}
+
+size_t SimulationState::state_bytes() const {
+    return potential.size() * sizeof(double) + has_spiked.size() +
+           spike_count.size() * sizeof(int) + step_spikes.capacity() * sizeof(uint32_t) +
+           input_buffer.size() * sizeof(double) + delay_ring.size() * sizeof(double);
+}
+
+void SimulationState::update() {
+    // The engines of engine_steps.h, as Network::step() and
+    // Network::step_two_phase() run them
+    const Model& m = *model;
+    const SpikeRoutes routes =
+        make_spike_routes(m.synapses, delay_slots > 0 ? m.delays.data() : nullptr);
+    const double* weights = m.synapses.weights.data();
+    const AccumulateKernel accumulate = accumulate_kernel;
+    const EngineNeurons neurons = {potential.data(), m.threshold.data(), m.resting.data(),
+                                   m.decay.data(), has_spiked.data(), spike_count.data(), size()};
+    const EngineDelays delays = {delay_ring.data(), delay_slots, sim_step};
+    auto deliver = [&routes, weights, accumulate](const uint32_t* spikes, size_t count,
+                                                  double* input) {
+        deliver_weights(routes, weights, accumulate, spikes, count, input);
+    };
+
+    step_spikes.resize(size());
+    if (mode == SimulationMode::TwoPhase) {
+        step_spikes.resize(two_phase_step(neurons, fire_kernel, routes, weights, delays,
+                                          input_buffer.data(), step_spikes.data(), deliver));
+    } else {
+        step_spikes.resize(time_driven_step(neurons, fire_kernel, m.synapses.sweep_chunks, routes,
+                                            weights, delays, step_spikes.data(), deliver));
+    }
+    ++sim_step;
+}
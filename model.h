@@ -0,0 +1,127 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+#include "network.h"
+#include "simd_kernels.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Immutable half of a Network: neuron parameters, synapses (weights, delays,
+// topology) and the data the engines derive from the topology. Nothing in a
+// Model changes after construction, so one std::shared_ptr<const Model> can
+// back any number of SimulationStates on any number of threads. Take one
+// with Network::make_model(); later changes to the network (connect(),
+// STDP) are not reflected, take a new one instead.
+//
+// Not to be confused with the neuron model policies of neuron_models.h: this
+// is the network model, i.e. what training produces.
+class Model {
+public:
+    // Copy the neuron parameters, synapses and delays of network
+    explicit Model(const Network& network);
+
+    // Get number of neurons
+    size_t size() const { return threshold.size(); }
+
+    // Get total number of connections
+    size_t connection_count() const { return synapses.targets.size(); }
+
+    // Largest synaptic delay (1 if every synapse delivers in the next step)
+    int max_delay() const { return longest_delay; }
+
+    // Bytes used by the parameter and synapse arrays
+    size_t model_bytes() const;
+
+private:
+    friend class SimulationState;
+
+    std::vector<double> threshold;
+    std::vector<double> resting;
+    std::vector<double> decay;
+
+    // CSR synapses, the chunks the sweep fires at once and the dense blocks
+    SnapshotSynapses<double> synapses;
+
+    // Delay of every synapse, empty when all are 1
+    std::vector<uint8_t> delays;
+    int longest_delay;
+};
+
+// Mutable half of a Network: the state of one simulation running on a shared
+// Model, i.e. membrane potentials, spike flags and counts, the spikes of the
+// last step and any synaptic input still in flight. It is a few bytes per
+// neuron, so inference workers each take one while the weights stay shared;
+// a copy is an independent simulation on the same model.
+//
+// Runs the time-driven engine (the reference, bit-identical to
+// Network::update()) or the two-phase engine (identical to Network's serial
+// two-phase engine), delays included. SimulationMode::EventDriven runs the
+// time-driven sweep instead: the same spike trains, up to the closed-form
+// decay caveat of Network::set_simulation_mode(). There is no learning:
+// the weights belong to the Model.
+class SimulationState {
+public:
+    // Start at rest on model
+    explicit SimulationState(std::shared_ptr<const Model> model);
+
+    // Model this state runs on
+    const Model& get_model() const { return *model; }
+
+    // Get number of neurons
+    size_t size() const { return potential.size(); }
+
+    // Select the simulation engine (see above)
+    void set_simulation_mode(SimulationMode new_mode);
+    SimulationMode get_simulation_mode() const { return mode; }
+
+    // Instruction set for the fire and accumulate kernels (defaults to the
+    // best available)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset all neurons to their resting state and drop input in flight
+    void reset();
+
+    // Apply external input current to neuron i
+    void apply_input(size_t i, double current) { potential[i] += current; }
+
+    // Advance the simulation by one time step
+    void update();
+
+    // Spike and potential accessors
+    bool spiked(size_t i) const { return has_spiked[i] != 0; }
+    int get_spike_count(size_t i) const { return spike_count[i]; }
+    double get_potential(size_t i) const { return potential[i]; }
+
+    // Neurons that spiked in the last step, in ascending index order
+    const std::vector<uint32_t>& get_step_spikes() const { return step_spikes; }
+
+    // Bytes used by this state (excluding the shared model)
+    size_t state_bytes() const;
+
+private:
+    std::shared_ptr<const Model> model;
+    SimulationMode mode;
+    int sim_step;  // Steps simulated since the last reset
+
+    std::vector<double> potential;
+    std::vector<unsigned char> has_spiked;
+    std::vector<int> spike_count;
+    std::vector<uint32_t> step_spikes;
+
+    // Two-phase input buffer, allocated when that engine is selected
+    std::vector<double> input_buffer;
+
+    // Input waiting for a later step, max_delay() + 1 slots of size()
+    // inputs; empty when the model has no delays
+    std::vector<double> delay_ring;
+    size_t delay_slots;
+
+    SimdLevel simd_level;
+    FireKernel fire_kernel;
+    AccumulateKernel accumulate_kernel;
+};
+
+#endif // MODEL_H
@@ -1,62 +1,733 @@
 #include "network.h"
+#include "model.h"
+#include "engine_steps.h"
+#include "allocation_counter.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
-#include <map>
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <cassert>
 
-Network::Network(size_t num_neurons) {
+// Longest gap the decay table covers directly; longer gaps multiply in
+// decay^DECAY_TABLE_STEPS once per DECAY_TABLE_STEPS steps
+static const int DECAY_TABLE_STEPS = 64;
+
+Network::Network(size_t num_neurons)
+    : mode(SimulationMode::TimeDriven), sim_step(0),
+      simd_level(detect_simd_level()), fire_kernel(select_fire_kernel(simd_level)),
+      accumulate_kernel(select_accumulate_kernel(simd_level)), topology_cache_version(0),
+      delay_slots(0), reset_everything(false) {
+    state.resize(num_neurons);
+    synapses.resize(num_neurons);
+    reset_version = synapses.version();
+    reset_mark.assign(num_neurons, 0);
+    spiked_rows.reserve(num_neurons);
+    input_neurons.reserve(num_neurons);
+    step_spikes.reserve(num_neurons);
+    synced_step.assign(num_neurons, 0);
+    queued_step.assign(num_neurons, -1);
+    pending_events.reserve(num_neurons);
+    event_heap.reserve(num_neurons);
+    input_buffer.assign(num_neurons, 0.0);
+    build_decay_table();
     neurons.reserve(num_neurons);
     for (size_t i = 0; i < num_neurons; ++i) {
-        neurons.emplace_back(new Neuron());
+        neurons.push_back(Neuron(this, &state, i));
     }
 }
 
 Neuron* Network::get_neuron(size_t index) {
     if (index < neurons.size()) {
-        return neurons[index].get();
+        return &neurons[index];
     }
     return nullptr;
 }
 
-void Network::connect(size_t from, size_t to, double weight) {
+void Network::connect(size_t from, size_t to, double weight, int delay) {
     if (from < neurons.size() && to < neurons.size() && from != to) {
-        neurons[from]->add_connection(neurons[to].get(), weight);
+        delay = std::max(1, std::min(MAX_SYNAPSE_DELAY, delay));
+        synapses.connect((uint32_t)from, (uint32_t)to, weight, (uint8_t)delay);
+    }
+}
+
+void Network::disconnect(size_t from, size_t to) {
+    if (from < neurons.size() && to < neurons.size()) {
+        synapses.disconnect((uint32_t)from, (uint32_t)to);
+    }
+}
+
+std::shared_ptr<const Model> Network::make_model() const {
+    return std::make_shared<const Model>(*this);
+}
+
+void Network::update_topology_cache() {
+    const uint64_t version = synapses.version();
+    if (version == topology_cache_version && !sweep_chunks.empty()) return;
+
+    synapses.sweep_chunks(sweep_chunks);
+    synapses.dense_blocks(dense_blocks, dense_block_of_row);
+    topology_cache_version = version;
+
+    // Reverse index for post-synaptic STDP, built here so the workers of
+    // apply_stdp() only read it
+    synapses.incoming_offsets_data();
+
+    // Slots for steps t .. t + max_delay. The ring only grows, so input
+    // already waiting keeps its due step; move it to its slot in the new size.
+    const size_t slots = synapses.max_delay() > 1 ? (size_t)synapses.max_delay() + 1 : 0;
+    if (slots > delay_slots) {
+        const size_t n = state.size();
+        std::vector<double> ring(slots * n, 0.0);
+        std::vector<unsigned char> listed(slots * n, 0);
+        std::vector<std::vector<uint32_t>> lists(slots);
+        for (size_t k = 0; k < delay_slots; ++k) {
+            const size_t from = (sim_step + k) % delay_slots;
+            const size_t to = (sim_step + k) % slots;
+            std::copy(delay_ring.begin() + from * n, delay_ring.begin() + (from + 1) * n,
+                      ring.begin() + to * n);
+            std::copy(delay_listed.begin() + from * n, delay_listed.begin() + (from + 1) * n,
+                      listed.begin() + to * n);
+            lists[to].swap(delay_targets[from]);
+        }
+        delay_ring.swap(ring);
+        delay_listed.swap(listed);
+        delay_targets.swap(lists);
+        delay_slots = slots;
+        for (auto& waiting : delay_targets) {
+            waiting.reserve(n);
+        }
+    }
+}
+
+EngineNeurons Network::engine_neurons() {
+    EngineNeurons neurons = {state.membrane_potential.data(), state.threshold.data(),
+                             state.resting_potential.data(), state.decay_factor.data(),
+                             state.has_spiked.data(), state.spike_count.data(), state.size()};
+    return neurons;
+}
+
+EngineDelays Network::engine_delays() {
+    EngineDelays delays = {delay_ring.data(), delay_slots, sim_step};
+    return delays;
+}
+
+void Network::schedule_delayed_input(uint32_t target, double weight, int due) {
+    const size_t slot = (size_t)due % delay_slots;
+    const size_t entry = slot * state.size() + target;
+    delay_ring[entry] += weight;
+    if (mode == SimulationMode::EventDriven && !delay_listed[entry]) {
+        delay_listed[entry] = 1;
+        delay_targets[slot].push_back(target);
+    }
+}
+
+void Network::clear_delay_targets() {
+    const size_t n = state.size();
+    for (size_t slot = 0; slot < delay_targets.size(); ++slot) {
+        for (uint32_t i : delay_targets[slot]) {
+            delay_listed[slot * n + i] = 0;
+        }
+        delay_targets[slot].clear();
+    }
+}
+
+void Network::step() {
+    // Time-driven sweep (see time_driven_step() in engine_steps.h) over the
+    // chunks from update_topology_cache()
+    update_topology_cache();
+    const SpikeRoutes routes = make_spike_routes(synapses, dense_blocks, dense_block_of_row);
+    const double* weights = synapses.weights_data();
+    const AccumulateKernel accumulate = accumulate_kernel;
+    step_spikes.resize(state.size());
+    step_spikes.resize(time_driven_step(engine_neurons(), fire_kernel, sweep_chunks, routes,
+                                        weights, engine_delays(), step_spikes.data(),
+        [&routes, weights, accumulate](const uint32_t* spikes, size_t count, double* input) {
+            deliver_weights(routes, weights, accumulate, spikes, count, input);
+        }));
+    ++sim_step;
+}
+
+void Network::step_event_driven() {
+    // Visit only neurons that received input, in ascending index order, so
+    // delivery matches the time-driven sweep exactly: a target with a higher
+    // index than the spiking neuron is visited in this same step, a lower one
+    // in the next. Every other neuron is below threshold and only decays,
+    // which sync_potential() applies in one step when the neuron is next
+    // touched.
+    // This relies on resting < threshold and 0 <= decay <= 1, which keeps a
+    // neuron without input from ever crossing threshold on its own.
+    const int t = sim_step;
+    double* potential = state.membrane_potential.data();
+    const double* threshold = state.threshold.data();
+    const double* resting = state.resting_potential.data();
+    const double* decay = state.decay_factor.data();
+    unsigned char* spiked = state.has_spiked.data();
+
+    update_topology_cache();
+    const uint32_t* offsets = synapses.offsets_data();
+    const uint32_t* targets = synapses.targets_data();
+    const double* weights = synapses.weights_data();
+    const uint8_t* delays = delay_slots > 0 ? synapses.delays_data() : nullptr;
+
+    for (uint32_t i : step_spikes) {
+        spiked[i] = 0;
+    }
+    step_spikes.clear();
+
+    // Delayed input due now joins the neurons queued for this step
+    if (delay_slots > 0) {
+        const size_t slot = (size_t)t % delay_slots;
+        double* waiting = delay_ring.data() + slot * state.size();
+        unsigned char* listed = delay_listed.data() + slot * state.size();
+        for (uint32_t i : delay_targets[slot]) {
+            sync_potential(i, t);
+            potential[i] += waiting[i];
+            waiting[i] = 0.0;
+            listed[i] = 0;
+            if (queued_step[i] != t) {
+                queued_step[i] = t;
+                pending_events.push_back(i);
+            }
+        }
+        delay_targets[slot].clear();
+    }
+
+    event_heap.swap(pending_events);
+    pending_events.clear();
+    std::make_heap(event_heap.begin(), event_heap.end(), std::greater<uint32_t>());
+
+    while (!event_heap.empty()) {
+        std::pop_heap(event_heap.begin(), event_heap.end(), std::greater<uint32_t>());
+        const uint32_t i = event_heap.back();
+        event_heap.pop_back();
+
+        sync_potential(i, t);
+        if (potential[i] >= threshold[i]) {
+            spiked[i] = 1;
+            state.spike_count[i]++;
+            step_spikes.push_back(i);
+            potential[i] = resting[i];
+            for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                if (delays != nullptr && delays[k] > 1) {
+                    schedule_delayed_input(targets[k], weights[k],
+                                           delayed_due(t, delays[k], i, targets[k], true));
+                } else {
+                    deliver_event(targets[k], weights[k], t, i);
+                }
+            }
+        } else {
+            potential[i] = resting[i] + (potential[i] - resting[i]) * decay[i];
+        }
+        synced_step[i] = t + 1;
+    }
+    ++sim_step;
+}
+
+void Network::step_two_phase() {
+    // See two_phase_step() in engine_steps.h
+    update_topology_cache();
+    const SpikeRoutes routes = make_spike_routes(synapses, dense_blocks, dense_block_of_row);
+    const double* weights = synapses.weights_data();
+    const AccumulateKernel accumulate = accumulate_kernel;
+    step_spikes.resize(state.size());
+    step_spikes.resize(two_phase_step(engine_neurons(), fire_kernel, routes, weights,
+                                      engine_delays(), input_buffer.data(), step_spikes.data(),
+        [&routes, weights, accumulate](const uint32_t* spikes, size_t count, double* input) {
+            deliver_weights(routes, weights, accumulate, spikes, count, input);
+        }));
+    ++sim_step;
+}
+
+void Network::step_two_phase_parallel() {
+    // Same phases as two_phase_step(), with each worker owning a contiguous
+    // slice of neurons. A worker fires its slice and scatters the resulting
+    // spikes into its private input buffer; after the join every worker folds
+    // all buffers into its own slice of potentials, in worker order, so the
+    // result is deterministic for a given thread count.
+    const size_t n = state.size();
+    const size_t workers = pool->size();
+    update_topology_cache();  // Before the workers start: delivery reads it
+    const EngineNeurons neurons = engine_neurons();
+    const EngineDelays delays = engine_delays();
+    const SpikeRoutes routes = make_spike_routes(synapses, dense_blocks, dense_block_of_row);
+    const double* weights = synapses.weights_data();
+    if (delays.slots > 0) {
+        apply_delay_slot(neurons.potential, delays.ring, delays.slots, delays.step, n);
+    }
+
+    auto fire = [&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::partition(n, workers, worker, begin, end);
+        std::vector<uint32_t>& spikes = worker_spikes[worker];
+        spikes.resize(end - begin);
+        spikes.resize(fire_neurons(neurons, fire_kernel, begin, end - begin, spikes.data()));
+        deliver_weights(routes, weights, accumulate_kernel, spikes.data(), spikes.size(),
+                        worker_inputs[worker].data());
+    };
+    pool->run(fire);
+
+    auto reduce = [&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::partition(n, workers, worker, begin, end);
+        for (size_t w = 0; w < workers; ++w) {
+            double* input = worker_inputs[w].data();
+            for (size_t i = begin; i < end; ++i) {
+                neurons.potential[i] += input[i];
+                input[i] = 0.0;
+            }
+        }
+    };
+    pool->run(reduce);
+
+    step_spikes.clear();
+    for (size_t w = 0; w < workers; ++w) {
+        step_spikes.insert(step_spikes.end(), worker_spikes[w].begin(), worker_spikes[w].end());
+    }
+    if (delays.slots > 0) {
+        // Delayed spikes land in a later step, so they can be queued after
+        // the join without changing this step
+        queue_delayed_spikes(routes, weights, delays, n, step_spikes.data(), step_spikes.size(),
+                             false);
+    }
+    ++sim_step;
+}
+
+void Network::build_decay_table() {
+    // Networks normally share one decay factor, so this is a single row
+    std::map<double, uint32_t> rows;
+    decay_row.resize(state.size());
+    decay_powers.clear();
+    for (size_t i = 0; i < state.size(); ++i) {
+        const double decay = state.decay_factor[i];
+        auto it = rows.find(decay);
+        if (it == rows.end()) {
+            it = rows.insert(std::make_pair(decay, (uint32_t)rows.size())).first;
+            double power = 1.0;
+            for (int k = 0; k <= DECAY_TABLE_STEPS; ++k) {
+                decay_powers.push_back(power);
+                power *= decay;
+            }
+        }
+        decay_row[i] = it->second;
+    }
+}
+
+double Network::decay_power(size_t i, int k) const {
+    const double* powers = decay_powers.data() + (size_t)decay_row[i] * (DECAY_TABLE_STEPS + 1);
+    double factor = 1.0;
+    for (; k > DECAY_TABLE_STEPS; k -= DECAY_TABLE_STEPS) {
+        factor *= powers[DECAY_TABLE_STEPS];
+    }
+    return factor * powers[k];
+}
+
+void Network::sync_potential(size_t i, int t) {
+    if (synced_step[i] >= t) return;
+
+    // Quiet steps are pure geometric decay towards resting, applied in
+    // closed form
+    const double v = state.membrane_potential[i];
+    const double resting = state.resting_potential[i];
+    if (v != resting) {
+        state.membrane_potential[i] = resting + (v - resting) * decay_power(i, t - synced_step[i]);
+    }
+    synced_step[i] = t;
+}
+
+void Network::deliver_event(uint32_t target, double weight, int t, uint32_t source) {
+    // Targets after the source in index order have not been visited yet
+    const int due = (target > source) ? t : t + 1;
+    sync_potential(target, due);
+    state.membrane_potential[target] += weight;
+
+    if (queued_step[target] != due) {
+        queued_step[target] = due;
+        if (due == t) {
+            event_heap.push_back(target);
+            std::push_heap(event_heap.begin(), event_heap.end(), std::greater<uint32_t>());
+        } else {
+            pending_events.push_back(target);
+        }
+    }
+}
+
+void Network::add_input(size_t i, double current) {
+    if (!(reset_mark[i] & 2)) {
+        reset_mark[i] |= 2;
+        input_neurons.push_back((uint32_t)i);
+    }
+    if (mode != SimulationMode::EventDriven) {
+        state.membrane_potential[i] += current;
+        return;
+    }
+
+    sync_potential(i, sim_step);
+    state.membrane_potential[i] += current;
+    if (queued_step[i] != sim_step) {
+        queued_step[i] = sim_step;
+        pending_events.push_back((uint32_t)i);
+    }
+}
+
+double Network::current_potential(size_t i) const {
+    const double v = state.membrane_potential[i];
+    if (mode == SimulationMode::EventDriven && synced_step[i] < sim_step) {
+        const double resting = state.resting_potential[i];
+        return resting + (v - resting) * decay_power(i, sim_step - synced_step[i]);
+    }
+    return v;
+}
+
+void Network::set_simulation_mode(SimulationMode new_mode) {
+    if (new_mode == mode) return;
+
+    const size_t n = state.size();
+    if (mode == SimulationMode::EventDriven) {
+        // Bring every stored potential up to date
+        for (size_t i = 0; i < n; ++i) {
+            sync_potential(i, sim_step);
+            queued_step[i] = -1;
+        }
+        pending_events.clear();
+        clear_delay_targets();
+    }
+    if (new_mode == SimulationMode::EventDriven) {
+        // Every neuron is current; queue the ones already at threshold
+        pending_events.clear();
+        for (size_t i = 0; i < n; ++i) {
+            synced_step[i] = sim_step;
+            queued_step[i] = -1;
+            if (state.membrane_potential[i] >= state.threshold[i]) {
+                queued_step[i] = sim_step;
+                pending_events.push_back((uint32_t)i);
+            }
+        }
+        // List the neurons with delayed input already waiting
+        for (size_t slot = 0; slot < delay_slots; ++slot) {
+            for (size_t i = 0; i < n; ++i) {
+                if (delay_ring[slot * n + i] != 0.0) {
+                    delay_listed[slot * n + i] = 1;
+                    delay_targets[slot].push_back((uint32_t)i);
+                }
+            }
+        }
+    }
+    mode = new_mode;
+    reset_everything = true;  // The event engine's bookkeeping changed for every neuron
+}
+
+void Network::update_neuron(size_t i) {
+    if (mode == SimulationMode::EventDriven) {
+        sync_potential(i, sim_step);
+    }
+
+    double* potential = state.membrane_potential.data();
+    const double resting = state.resting_potential[i];
+
+    state.has_spiked[i] = 0;
+    if (potential[i] >= state.threshold[i]) {
+        state.has_spiked[i] = 1;
+        state.spike_count[i]++;
+        potential[i] = resting;
+        const uint32_t source = (uint32_t)i;
+        mark_spikes(&source, 1);
+
+        const uint32_t* targets = synapses.targets_data();
+        const double* weights = synapses.weights_data();
+        for (uint32_t k = synapses.row_begin(i); k < synapses.row_end(i); ++k) {
+            add_input(targets[k], weights[k]);
+        }
+    } else {
+        potential[i] = resting + (potential[i] - resting) * state.decay_factor[i];
+    }
+}
+
+void Network::update_stdp_row(size_t i, double learning_rate, double tau_plus, double tau_minus) {
+    const int last_spike_time = state.last_spike_time[i];
+    if (last_spike_time < 0) return; // No spike history
+
+    if (!row_stdp_kernel.matches(learning_rate, tau_plus, tau_minus)) {
+        row_stdp_kernel.configure(learning_rate, tau_plus, tau_minus);
+    }
+    const uint32_t* targets = synapses.targets_data();
+    double* weights = synapses.weights_data();
+    for (uint32_t k = synapses.row_begin(i); k < synapses.row_end(i); ++k) {
+        int post_spike_time = state.last_spike_time[targets[k]];
+        if (post_spike_time < 0) continue; // Post-synaptic neuron hasn't spiked
+
+        // LTP if pre came before post, LTD if post came before pre
+        row_stdp_kernel.apply(weights[k], post_spike_time - last_spike_time);
     }
 }
 
 void Network::update() {
-    // First, update all neurons
-    for (auto& neuron : neurons) {
-        neuron->update();
+    switch (mode) {
+        case SimulationMode::EventDriven:
+            step_event_driven();
+            break;
+        case SimulationMode::TwoPhase:
+            if (pool) {
+                step_two_phase_parallel();
+            } else {
+                step_two_phase();
+            }
+            break;
+        default:
+            step();
+            break;
     }
+    mark_spikes(step_spikes.data(), step_spikes.size());
+}
+
+void Network::depress_row(uint32_t i, int t) {
+    double* weights = synapses.weights_data();
+    stdp_depress_row(synapses, stdp_kernel, state.last_spike_time.data(), i, t,
+                     [weights](uint32_t slot) { return weights[slot]; },
+                     [weights](uint32_t slot, double weight) { weights[slot] = weight; });
+}
+
+void Network::potentiate_column(uint32_t j, int t) {
+    double* weights = synapses.weights_data();
+    stdp_potentiate_column(synapses, stdp_kernel, state.last_spike_time.data(), j, t,
+                           [weights](uint32_t slot) { return weights[slot]; },
+                           [weights](uint32_t slot, double weight) { weights[slot] = weight; });
 }
 
 void Network::update_with_learning(int time_step, double learning_rate) {
+#ifdef COUNT_ALLOCATIONS
+    // Only rebuilding the topology caches after an edit may allocate
+    const bool steady = !sweep_chunks.empty() && topology_cache_version == synapses.version();
+    const uint64_t allocations = heap_allocation_count();
+#endif
+
     // Update all neurons
-    for (auto& neuron : neurons) {
-        neuron->update();
+    update();
+    
+    // Apply STDP learning rule; last_spike_time still holds the spikes
+    // before this step, which are what the traces decay from
+    if (!stdp_kernel.matches(learning_rate, STDP_TAU_PLUS, STDP_TAU_MINUS)) {
+        stdp_kernel.configure(learning_rate, STDP_TAU_PLUS, STDP_TAU_MINUS);
     }
+    apply_stdp(time_step);
     
     // Set time step for spike tracking
-    for (auto& neuron : neurons) {
-        neuron->set_time_step(time_step);
+    for (uint32_t i : step_spikes) {
+        neurons[i].set_time_step(time_step);
     }
-    
-    // Apply STDP learning rule
-    for (auto& neuron : neurons) {
-        neuron->update_stdp(time_step, learning_rate);
+
+#ifdef COUNT_ALLOCATIONS
+    assert(!steady || heap_allocation_count() == allocations);
+#endif
+}
+
+void Network::apply_stdp(int t) {
+    // A trace is 1 at its neuron's last spike and decays by exp(-1/tau) per
+    // step, so it is looked up in stdp_kernel by the steps since
+    // last_spike_time when a spike reads it and quiet steps cost nothing.
+    // Depression of all rows comes before potentiation of all columns, so a
+    // synapse whose two ends both spiked is updated in a fixed order.
+    if (!pool) {
+        for (uint32_t i : step_spikes) {
+            depress_row(i, t);
+        }
+        for (uint32_t j : step_spikes) {
+            potentiate_column(j, t);
+        }
+        return;
+    }
+
+    // Each spike writes only its own row (column), so the spikes of a pass
+    // can be split freely between workers
+    const size_t workers = pool->size();
+    const size_t count = step_spikes.size();
+    auto depress = [&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::partition(count, workers, worker, begin, end);
+        for (size_t s = begin; s < end; ++s) {
+            depress_row(step_spikes[s], t);
+        }
+    };
+    pool->run(depress);
+    auto potentiate = [&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::partition(count, workers, worker, begin, end);
+        for (size_t s = begin; s < end; ++s) {
+            potentiate_column(step_spikes[s], t);
+        }
+    };
+    pool->run(potentiate);
+}
+
+void Network::set_simd_level(SimdLevel level) {
+    // Clamp to what the CPU supports
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
     }
+    simd_level = level;
+    fire_kernel = select_fire_kernel(level);
+    accumulate_kernel = select_accumulate_kernel(level);
+}
+
+void Network::set_num_threads(size_t num_threads) {
+    if (num_threads <= 1) {
+        pool.reset();
+        worker_spikes.clear();
+        worker_inputs.clear();
+        return;
+    }
+
+    pool.reset(new ThreadPool(num_threads));
+    worker_spikes.assign(num_threads, std::vector<uint32_t>());
+    for (auto& spikes : worker_spikes) {
+        spikes.reserve(state.size());
+    }
+    worker_inputs.assign(num_threads, std::vector<double>(state.size(), 0.0));
+}
+
+void Network::mark_spikes(const uint32_t* spikes, size_t count) {
+    for (size_t s = 0; s < count; ++s) {
+        const uint32_t i = spikes[s];
+        if (!(reset_mark[i] & 1)) {
+            reset_mark[i] |= 1;
+            spiked_rows.push_back(i);
+        }
+    }
+}
+
+void Network::reset_neuron(size_t i) {
+    state.reset(i);
+    synced_step[i] = 0;
+    queued_step[i] = -1;
+    const size_t n = state.size();
+    for (size_t slot = 0; slot < delay_slots; ++slot) {
+        delay_ring[slot * n + i] = 0.0;
+    }
+}
+
+bool Network::reset_touched() {
+    // The targets of a spiked row must be the ones it delivered to, and the
+    // dense blocks must describe that topology
+    const size_t n = state.size();
+    if (reset_everything || synapses.version() != reset_version ||
+        topology_cache_version != reset_version || sweep_chunks.empty()) {
+        return false;
+    }
+
+    // A dense block's targets are visited once however many of its rows spiked
+    const uint32_t* offsets = synapses.offsets_data();
+    block_reset.assign(dense_blocks.size(), 0);
+    size_t work = input_neurons.size() + spiked_rows.size();
+    for (uint32_t i : spiked_rows) {
+        const int32_t b = dense_block_of_row[i];
+        if (b < 0) {
+            work += offsets[i + 1] - offsets[i];
+        } else if (!block_reset[b]) {
+            block_reset[b] = 1;
+            work += dense_blocks[b].width();
+        }
+        if (work >= n) return false;
+    }
+
+    const uint32_t* targets = synapses.targets_data();
+    for (uint32_t i : input_neurons) {
+        reset_neuron(i);
+    }
+    for (uint32_t i : spiked_rows) {
+        reset_neuron(i);
+        const int32_t b = dense_block_of_row[i];
+        if (b < 0) {
+            for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                reset_neuron(targets[k]);
+            }
+        } else if (block_reset[b]) {
+            block_reset[b] = 0;
+            for (uint32_t t = dense_blocks[b].target_begin; t < dense_blocks[b].target_end; ++t) {
+                reset_neuron(t);
+            }
+        }
+    }
+    return true;
+}
+
+void Network::clear_reset_lists() {
+    for (uint32_t i : spiked_rows) {
+        reset_mark[i] = 0;
+    }
+    for (uint32_t i : input_neurons) {
+        reset_mark[i] = 0;
+    }
+    spiked_rows.clear();
+    input_neurons.clear();
 }
 
 void Network::reset() {
-    for (auto& neuron : neurons) {
-        neuron->reset();
+    if (!reset_touched()) {
+        for (size_t i = 0; i < state.size(); ++i) {
+            state.reset(i);
+        }
+        std::fill(synced_step.begin(), synced_step.end(), 0);
+        std::fill(queued_step.begin(), queued_step.end(), -1);
+        std::fill(delay_ring.begin(), delay_ring.end(), 0.0);
+    }
+    sim_step = 0;
+    step_spikes.clear();
+    pending_events.clear();
+    clear_delay_targets();
+    clear_reset_lists();
+    reset_everything = false;
+    reset_version = synapses.version();
+}
+
+void Network::save_snapshot() {
+    const size_t n = state.size();
+    snapshot_potential.resize(n);
+    snapshot_queued.clear();
+    for (size_t i = 0; i < n; ++i) {
+        snapshot_potential[i] = current_potential(i);
+        if (snapshot_potential[i] >= state.threshold[i]) {
+            snapshot_queued.push_back((uint32_t)i);
+        }
     }
 }
 
+void Network::reset_to_snapshot() {
+    if (snapshot_potential.size() != state.size()) {
+        reset();
+        return;
+    }
+
+    // Only neurons that spiked have spike statistics to clear; every
+    // potential then comes from the snapshot
+    for (uint32_t i : spiked_rows) {
+        state.reset(i);
+    }
+    std::copy(snapshot_potential.begin(), snapshot_potential.end(),
+              state.membrane_potential.begin());
+
+    sim_step = 0;
+    step_spikes.clear();
+    pending_events.clear();
+    std::fill(delay_ring.begin(), delay_ring.end(), 0.0);
+    clear_delay_targets();
+    if (mode == SimulationMode::EventDriven) {
+        std::fill(synced_step.begin(), synced_step.end(), 0);
+        std::fill(queued_step.begin(), queued_step.end(), -1);
+        for (uint32_t i : snapshot_queued) {
+            queued_step[i] = 0;
+            pending_events.push_back(i);
+        }
+    }
+    clear_reset_lists();
+    // Untouched neurons now hold the baseline rather than resting
+    reset_everything = true;
+    reset_version = synapses.version();
+}
+
 void Network::print_state() const {
     std::cout << "\nNetwork State:\n";
     std::cout << "Neuron | Potential | Spiked | Spike Count | Connections\n";
@@ -65,21 +736,19 @@ void Network::print_state() const {
     for (size_t i = 0; i < neurons.size(); ++i) {
         std::cout << std::setw(6) << i << " | "
                   << std::setw(9) << std::fixed << std::setprecision(3) 
-                  << neurons[i]->get_potential() << " | "
-                  << std::setw(6) << (neurons[i]->spiked() ? "Yes" : "No") << " | "
-                  << std::setw(11) << neurons[i]->get_spike_count() << " | "
-                  << std::setw(11) << neurons[i]->get_connection_count() << "\n";
+                  << neurons[i].get_potential() << " | "
+                  << std::setw(6) << (neurons[i].spiked() ? "Yes" : "No") << " | "
+                  << std::setw(11) << neurons[i].get_spike_count() << " | "
+                  << std::setw(11) << neurons[i].get_connection_count() << "\n";
     }
     std::cout << std::endl;
 }
 
 void Network::export_to_json(std::ostream& out) const {
-    // Create mapping from neuron pointer to index
-    std::map<const Neuron*, size_t> neuron_to_index;
-    for (size_t i = 0; i < neurons.size(); ++i) {
-        neuron_to_index[neurons[i].get()] = i;
-    }
-    
+    const uint32_t* targets = synapses.targets_data();
+    const double* weights = synapses.weights_data();
+    const uint8_t* delays = synapses.delays_data();
+
     out << "{\n";
     out << "  \"neurons\": [\n";
     
@@ -87,23 +756,24 @@ void Network::export_to_json(std::ostream& out) const {
         out << "    {\n";
         out << "      \"id\": " << i << ",\n";
         out << "      \"potential\": " << std::fixed << std::setprecision(4) 
-            << neurons[i]->get_potential() << ",\n";
-        out << "      \"spiked\": " << (neurons[i]->spiked() ? "true" : "false") << ",\n";
-        out << "      \"spike_count\": " << neurons[i]->get_spike_count() << ",\n";
+            << neurons[i].get_potential() << ",\n";
+        out << "      \"spiked\": " << (neurons[i].spiked() ? "true" : "false") << ",\n";
+        out << "      \"spike_count\": " << neurons[i].get_spike_count() << ",\n";
         out << "      \"connections\": [\n";
         
-        const auto& connections = neurons[i]->get_connections();
-        for (size_t j = 0; j < connections.size(); ++j) {
-            auto it = neuron_to_index.find(connections[j].target);
-            if (it != neuron_to_index.end()) {
-                out << "        {\"target\": " << it->second 
-                    << ", \"weight\": " << std::fixed << std::setprecision(4) 
-                    << connections[j].weight << "}";
-                if (j < connections.size() - 1) {
-                    out << ",";
-                }
-                out << "\n";
+        const uint32_t row_end = synapses.row_end(i);
+        for (uint32_t k = synapses.row_begin(i); k < row_end; ++k) {
+            out << "        {\"target\": " << targets[k]
+                << ", \"weight\": " << std::fixed << std::setprecision(4)
+                << weights[k];
+            if (delays[k] != 1) {
+                out << ", \"delay\": " << (int)delays[k];
+            }
+            out << "}";
+            if (k < row_end - 1) {
+                out << ",";
             }
+            out << "\n";
         }
         
         out << "      ]\n";
@@ -193,6 +863,7 @@ Network* Network::load_from_json(const std::string& filename) {
     bool in_connection_obj = false;
     int target = -1;
     double weight = 0.0;
+    int delay = 1;
     
     while (std::getline(file, line)) {
         // Find neuron id
@@ -227,21 +898,13 @@ Network* Network::load_from_json(const std::string& filename) {
             continue;
         }
         
-        // Check if entering a connection object
+        // Check if entering a connection object (export writes each
+        // connection on a single line, so keep parsing this line)
         if (in_connections && line.find('{') != std::string::npos) {
             in_connection_obj = true;
             target = -1;
             weight = 0.0;
-            continue;
-        }
-        
-        // Check if exiting a connection object
-        if (in_connection_obj && line.find('}') != std::string::npos) {
-            if (current_neuron >= 0 && target >= 0) {
-                network->connect(current_neuron, target, weight);
-            }
-            in_connection_obj = false;
-            continue;
+            delay = 1;
         }
         
         // Read target
@@ -283,9 +946,29 @@ Network* Network::load_from_json(const std::string& filename) {
                 }
             }
         }
+        
+        // Read delay (only written when it is not 1)
+        if (in_connection_obj) {
+            size_t delay_pos = line.find("\"delay\"");
+            if (delay_pos != std::string::npos) {
+                size_t colon_pos = line.find(':', delay_pos);
+                if (colon_pos != std::string::npos) {
+                    delay = std::stoi(line.substr(colon_pos + 1));
+                }
+            }
+        }
+        
+        // Check if exiting a connection object
+        if (in_connection_obj && line.find('}') != std::string::npos) {
+            if (current_neuron >= 0 && target >= 0) {
+                network->connect(current_neuron, target, weight, delay);
+            }
+            in_connection_obj = false;
+        }
     }
     
     file.close();
+    network->synapses.compact();
     return network;
 }
 
@@ -2,44 +2,318 @@
 #define NETWORK_H
 
 #include "neuron.h"
+#include "synapse_store.h"
+#include "engine_steps.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+#include "stdp_kernel.h"
 #include <vector>
 #include <memory>
+#include <string>
+#include <ostream>
+#include <algorithm>
+
+// Simulation engine used by update() and update_with_learning()
+enum class SimulationMode {
+    TimeDriven,   // Visit every neuron every step (reference engine)
+    EventDriven,  // Visit only neurons with pending input; decay applied lazily
+    TwoPhase      // Fire all neurons, then deliver all spikes (order independent)
+};
+
+class Model;
 
 class Network {
 private:
-    std::vector<std::unique_ptr<Neuron>> neurons;
+    NeuronState state;            // Contiguous per-field neuron state
+    SynapseStore synapses;        // CSR synapse storage (all connections)
+    std::vector<Neuron> neurons;  // Views into state (sized once, never reallocated)
+
+    SimulationMode mode;
+    int sim_step;                         // Steps simulated since the last reset
+    std::vector<uint32_t> step_spikes;    // Neurons that spiked in the last step
+
+    // Vectorized threshold/decay and row-accumulate kernels, plus data derived
+    // from the synapse topology (cached per SynapseStore::version()): the
+    // chunks the time-driven sweep fires at once and the dense layer blocks
+    // whose spikes are delivered as a blocked sparse-vector x matrix product
+    SimdLevel simd_level;
+    FireKernel fire_kernel;
+    AccumulateKernel accumulate_kernel;
+    std::vector<uint32_t> sweep_chunks;
+    std::vector<DenseBlock> dense_blocks;
+    std::vector<int32_t> dense_block_of_row;
+    uint64_t topology_cache_version;
+
+    // Tabulated STDP factors: stdp_kernel for update_with_learning(),
+    // row_stdp_kernel for Neuron::update_stdp() (which takes its own time
+    // constants); each is retabulated when called with other parameters
+    StdpKernel stdp_kernel;
+    StdpKernel row_stdp_kernel;
+
+    // Event-driven engine state. A neuron's stored potential is valid as of
+    // the start of step synced_step[i]; the steps in between were quiet
+    // (below threshold, no input) and are applied as plain decay on demand.
+    std::vector<int> synced_step;         // Step the stored potential belongs to
+    std::vector<int> queued_step;         // Step the neuron is queued for (-1 if none)
+    std::vector<uint32_t> pending_events; // Neurons queued for the next step
+    std::vector<uint32_t> event_heap;     // Min-heap of neurons to visit this step
+
+    // Closed-form lazy decay: row decay_row[i] of decay_powers holds
+    // decay^0 .. decay^DECAY_TABLE_STEPS for neuron i's decay factor (one
+    // row per distinct factor), so catching up k quiet steps is one multiply
+    std::vector<double> decay_powers;
+    std::vector<uint32_t> decay_row;
+
+    // Two-phase engine state: synaptic input produced during a step, applied
+    // to the potentials only after every neuron has been evaluated
+    std::vector<double> input_buffer;
+
+    // Synaptic delays. Input due at step s from a synapse with delay > 1
+    // waits in slot s % delay_slots of delay_ring (one row of size() inputs
+    // per slot) and is added to the potentials before step s fires; delay-1
+    // synapses keep each engine's own delivery. delay_targets lists the
+    // neurons with input waiting in each slot, once each, as flagged in
+    // delay_listed (event-driven engine only; the lists are reserved up
+    // front so they never grow during a step). delay_slots is 0 until some
+    // synapse has a delay above 1.
+    std::vector<double> delay_ring;
+    std::vector<std::vector<uint32_t>> delay_targets;
+    std::vector<unsigned char> delay_listed;
+    size_t delay_slots;
+
+    // Parallel two-phase engine: a worker pool plus one spike list and one
+    // input accumulator per worker, reduced into the potentials after each
+    // step so the hot loops need no atomics
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<std::vector<uint32_t>> worker_spikes;
+    std::vector<std::vector<double>> worker_inputs;
+
+    // Reset bookkeeping. Only neurons that spiked and the targets of their
+    // synapses, or neurons given external input, can have left the resting
+    // state since the last reset, so reset() visits just those. reset_mark
+    // flags list membership (1: spiked_rows, 2: input_neurons). A topology
+    // change or an engine switch forces the next reset() to visit every neuron.
+    std::vector<uint32_t> spiked_rows;     // Neurons that spiked since the last reset
+    std::vector<uint32_t> input_neurons;   // Neurons given external input since then
+    std::vector<unsigned char> reset_mark;
+    std::vector<unsigned char> block_reset;  // Dense blocks already visited by reset()
+    bool reset_everything;
+    uint64_t reset_version;               // SynapseStore::version() at the last reset
+
+    // Baseline for reset_to_snapshot(): potentials as of save_snapshot(), and
+    // the neurons at or above threshold in it (queued by the event engine)
+    std::vector<double> snapshot_potential;
+    std::vector<uint32_t> snapshot_queued;
+
+    friend class Neuron;
+    friend class LearningState;
+
+    // One time-driven sweep over the state arrays
+    void step();
+
+    // Recompute sweep_chunks and the dense blocks if the topology changed,
+    // and grow the delay ring to cover the longest delay
+    void update_topology_cache();
+
+    // The state arrays and delay ring as the shared engines of
+    // engine_steps.h take them (valid until the next topology change)
+    EngineNeurons engine_neurons();
+    EngineDelays engine_delays();
+
+    // Add weight to the delay ring slot of step due for target
+    void schedule_delayed_input(uint32_t target, double weight, int due);
+
+    // Empty delay_targets and clear delay_listed
+    void clear_delay_targets();
+
+    // One event-driven step over the queued neurons only
+    void step_event_driven();
+
+    // One two-phase step: evaluate all neurons, then deliver buffered input
+    void step_two_phase();
+
+    // Two-phase step with neurons partitioned across the worker pool
+    void step_two_phase_parallel();
+
+    // Trace-based STDP for the spikes of the step at time t, split across
+    // the worker pool if there is one (see update_with_learning())
+    void apply_stdp(int t);
+
+    // Depress the outgoing synapses of neuron i, which spiked at time t
+    void depress_row(uint32_t i, int t);
+
+    // Potentiate the incoming synapses of neuron j, which spiked at time t
+    void potentiate_column(uint32_t j, int t);
+
+    // Build decay_powers/decay_row from the neuron decay factors
+    void build_decay_table();
+
+    // decay^k for neuron i, from the table
+    double decay_power(size_t i, int k) const;
+
+    // Apply the quiet decay steps since synced_step[i] so neuron i is
+    // current as of step t
+    void sync_potential(size_t i, int t);
+
+    // Deliver a spike from source to target during step t (event-driven)
+    void deliver_event(uint32_t target, double weight, int t, uint32_t source);
+
+    // Add external input to neuron i before the next step
+    void add_input(size_t i, double current);
+
+    // Membrane potential of neuron i as of the current step
+    double current_potential(size_t i) const;
+
+    // Record spikes in spiked_rows for reset()
+    void mark_spikes(const uint32_t* spikes, size_t count);
+
+    // Return neuron i to the resting state, including engine bookkeeping
+    void reset_neuron(size_t i);
+
+    // Reset the neurons in spiked_rows and input_neurons, and the targets of
+    // the spiked rows, if that is less work than a full sweep (returns false
+    // without doing anything otherwise)
+    bool reset_touched();
+
+    // Clear spiked_rows, input_neurons and their marks
+    void clear_reset_lists();
+
+    // Update a single neuron (threshold/decay and spike delivery)
+    void update_neuron(size_t i);
+
+    // Apply STDP to the outgoing synapses of neuron i
+    void update_stdp_row(size_t i, double learning_rate, double tau_plus, double tau_minus);
 
 public:
     // Constructor: creates a network with specified number of neurons
     Network(size_t num_neurons);
-    
+
+    // Networks hold views into their own storage and cannot be copied
+    Network(const Network&) = delete;
+    Network& operator=(const Network&) = delete;
+
     // Get neuron at index
     Neuron* get_neuron(size_t index);
-    
-    // Connect two neurons
-    void connect(size_t from, size_t to, double weight);
-    
+
+    // Connect two neurons (updates the weight and delay if the connection
+    // exists). A spike reaches the target delay steps later than it would
+    // with delay 1, the default: the same step for a later neuron in the
+    // time- and event-driven sweeps, the next step otherwise. Delays are
+    // clamped to [1, MAX_SYNAPSE_DELAY]. The inference snapshots
+    // (CompiledNetwork, QuantizedNetwork, BatchedNetwork) and Neuron::update()
+    // treat every synapse as delay 1.
+    void connect(size_t from, size_t to, double weight, int delay = 1);
+
+    // Remove the connection between two neurons
+    void disconnect(size_t from, size_t to);
+
+    // Bulk connect() with delay 1: connect_dense() links every neuron of
+    // [from_begin, from_end) to every neuron of [to_begin, to_end) (a fully
+    // connected layer), connect_sparse() the (from, to) pairs given. Weights
+    // come from init(from, to), called for every pair in the same order as
+    // the equivalent connect() loop, so a seeded generator gives the same
+    // network. Pairs out of range or from a neuron to itself are skipped
+    // after init() is called, as connect() skips them after its weight
+    // argument is evaluated. connect_dense() clips its ranges to the network
+    // first. Much faster than connect() for whole layers (see
+    // SynapseStore::connect_dense()).
+    template <typename Init>
+    void connect_dense(size_t from_begin, size_t from_end, size_t to_begin, size_t to_end,
+                       Init init) {
+        const size_t n = size();
+        synapses.connect_dense((uint32_t)std::min(from_begin, n), (uint32_t)std::min(from_end, n),
+                               (uint32_t)std::min(to_begin, n), (uint32_t)std::min(to_end, n),
+                               init);
+    }
+    template <typename Init>
+    void connect_sparse(const std::vector<std::pair<uint32_t, uint32_t>>& pairs, Init init) {
+        synapses.connect_sparse(pairs, init);
+    }
+
+    // Get total number of connections
+    size_t connection_count() const { return synapses.size(); }
+
+    // Get synapse storage (for export/analysis)
+    const SynapseStore& get_synapses() const { return synapses; }
+
+    // Snapshot the neuron parameters and synapses into an immutable Model.
+    // Simulations that only run inference can share it, each with its own
+    // small SimulationState (see model.h), instead of copying the network.
+    std::shared_ptr<const Model> make_model() const;
+
+    // Get neuron state arrays (parameters are always current; in event-driven
+    // mode stored potentials may lag, use Neuron::get_potential() for those)
+    const NeuronState& get_state() const { return state; }
+
+    // Select the simulation engine. Time- and event-driven deliver spikes in
+    // the same order, but event-driven applies quiet decay in closed form
+    // (decay^k in one multiply), so a potential can differ from the stepwise
+    // result by an ulp or so. Their spike trains are identical unless a
+    // potential lands within that distance of threshold, where a spike can
+    // appear or vanish; in practice they match. Two-phase delivers every
+    // spike in the following step.
+    void set_simulation_mode(SimulationMode new_mode);
+    SimulationMode get_simulation_mode() const { return mode; }
+
+    // Instruction set for the threshold/decay kernel. Defaults to the best the
+    // CPU supports; every level gives bit-identical results.
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Number of worker threads used by the two-phase engine and by STDP in
+    // update_with_learning() (1 = serial, the default)
+    void set_num_threads(size_t num_threads);
+    size_t get_num_threads() const { return pool ? pool->size() : 1; }
+
     // Update all neurons in the network (one time step)
     void update();
-    
-    // Update with learning (STDP)
+
+    // Update with learning (STDP). Every neuron has a pre- and a
+    // post-synaptic trace that is 1 at its last spike and decays by
+    // exp(-1/tau) per step (tau = 20). A spike of neuron i at time_step
+    // depresses each outgoing synapse i -> j by learning_rate times j's trace,
+    // and potentiates each incoming synapse h -> i by learning_rate times h's
+    // trace; spikes of the same step do not pair. Weights are clamped to
+    // [0, 1]. Only spiking neurons are visited, so each spike pair is
+    // counted once and the cost follows the spike count.
+    // Apart from the first step after a topology change, a step makes no
+    // heap allocation; builds with COUNT_ALLOCATIONS assert this (see
+    // allocation_counter.h).
     void update_with_learning(int time_step, double learning_rate = 0.01);
-    
+
+    // Number of recent spike times each neuron keeps (default
+    // DEFAULT_SPIKE_HISTORY_CAPACITY, 0 keeps none). The history is
+    // preallocated, so changing the capacity clears it.
+    void set_spike_history_capacity(size_t capacity) { state.set_history_capacity(capacity); }
+    size_t get_spike_history_capacity() const { return state.history_capacity; }
+
     // Get number of neurons
     size_t size() const { return neurons.size(); }
-    
-    // Reset all neurons
+
+    // Neurons that spiked in the last step, in ascending index order
+    const std::vector<uint32_t>& get_step_spikes() const { return step_spikes; }
+
+    // Reset all neurons to rest. Costs O(neurons touched since the last
+    // reset) rather than O(size()) when few neurons were active.
     void reset();
-    
+
+    // Record the current membrane potentials as the baseline state for
+    // reset_to_snapshot()
+    void save_snapshot();
+
+    // Reset to the saved baseline: spike counts and history cleared as in
+    // reset(), potentials restored with one bulk copy (reset() if no
+    // snapshot was saved)
+    void reset_to_snapshot();
+
     // Print network state
     void print_state() const;
-    
+
     // Export network state to JSON (for visualization)
     void export_to_json(std::ostream& out) const;
-    
+
     // Load network from JSON file (weights and connections)
     static Network* load_from_json(const std::string& filename);
 };
 
 #endif // NETWORK_H
-
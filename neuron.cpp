@@ -1,19 +1,71 @@
 #include "neuron.h"
+#include "network.h"
+#include "stdp_kernel.h"
 #include <algorithm>
 
+void NeuronState::resize(size_t n, double threshold_value, double resting, double decay) {
+    membrane_potential.resize(n, resting);
+    threshold.resize(n, threshold_value);
+    resting_potential.resize(n, resting);
+    decay_factor.resize(n, decay);
+    has_spiked.resize(n, 0);
+    spike_count.resize(n, 0);
+    last_spike_time.resize(n, -1);
+    spike_history.resize(n * history_capacity, 0);
+    history_recorded.resize(n, 0);
+}
+
+void NeuronState::reset(size_t i) {
+    membrane_potential[i] = resting_potential[i];
+    has_spiked[i] = 0;
+    spike_count[i] = 0;
+    last_spike_time[i] = -1;
+    history_recorded[i] = 0;
+}
+
+void NeuronState::set_history_capacity(size_t capacity) {
+    history_capacity = capacity;
+    spike_history.assign(size() * capacity, 0);
+    std::fill(history_recorded.begin(), history_recorded.end(), 0);
+}
+
+void NeuronState::record_spike(size_t i, int time) {
+    if (history_capacity == 0) return;
+    spike_history[i * history_capacity + history_recorded[i] % history_capacity] = time;
+    history_recorded[i]++;
+}
+
+int NeuronState::history_at(size_t i, size_t k) const {
+    // The oldest entry sits in the slot the next spike will overwrite
+    const size_t oldest = history_recorded[i] - history_size(i);
+    return spike_history[i * history_capacity + (oldest + k) % history_capacity];
+}
+
+Neuron::Neuron(Network* network, NeuronState* state, size_t index)
+    : state(state), index(index), network(network) {
+}
+
 Neuron::Neuron(double threshold, double resting, double decay)
-    : membrane_potential(resting), threshold(threshold), 
-      resting_potential(resting), decay_factor(decay),
-      has_spiked(false), spike_count(0), last_spike_time(-1) {
+    : state(nullptr), index(0), network(nullptr), owned_state(new NeuronState()) {
+    owned_state->resize(1, threshold, resting, decay);
+    state = owned_state.get();
 }
 
 void Neuron::add_connection(Neuron* target, double weight) {
+    if (network != nullptr) {
+        // Network-owned neurons keep their synapses in the network's CSR store
+        if (target != nullptr && target->network == network) {
+            network->connect(index, target->index, weight);
+        }
+        return;
+    }
+
     // Check if connection already exists
     auto it = std::find_if(connections.begin(), connections.end(),
         [target](const Connection& conn) {
             return conn.target == target;
         });
-    
+
     if (it == connections.end()) {
         connections.emplace_back(target, weight);
     } else {
@@ -23,6 +75,13 @@ void Neuron::add_connection(Neuron* target, double weight) {
 }
 
 void Neuron::remove_connection(Neuron* target) {
+    if (network != nullptr) {
+        if (target != nullptr && target->network == network) {
+            network->disconnect(index, target->index);
+        }
+        return;
+    }
+
     connections.erase(
         std::remove_if(connections.begin(), connections.end(),
             [target](const Connection& conn) {
@@ -32,20 +91,42 @@ void Neuron::remove_connection(Neuron* target) {
     );
 }
 
+size_t Neuron::get_connection_count() const {
+    if (network != nullptr) {
+        return network->synapses.out_degree(index);
+    }
+    return connections.size();
+}
+
+size_t Neuron::get_incoming_count() const {
+    if (network != nullptr) {
+        return network->synapses.in_degree(index);
+    }
+    return 0;
+}
+
 void Neuron::update() {
+    if (network != nullptr) {
+        network->update_neuron(index);
+        return;
+    }
+
+    double& membrane_potential = state->membrane_potential[index];
+    const double resting_potential = state->resting_potential[index];
+
     // Reset spike flag
-    has_spiked = false;
-    
+    state->has_spiked[index] = 0;
+
     // Check if threshold is reached (before decay)
-    if (membrane_potential >= threshold) {
+    if (membrane_potential >= state->threshold[index]) {
         // Neuron spikes
-        has_spiked = true;
-        spike_count++;
+        state->has_spiked[index] = 1;
+        state->spike_count[index]++;
         // Note: last_spike_time will be set by set_time_step() after update
-        
+
         // Reset membrane potential after spike
         membrane_potential = resting_potential;
-        
+
         // Send spikes to all connected neurons
         for (auto& conn : connections) {
             if (conn.target != nullptr) {
@@ -54,68 +135,70 @@ void Neuron::update() {
         }
     } else {
         // Decay membrane potential towards resting potential (only if no spike)
-        membrane_potential = resting_potential + 
-                            (membrane_potential - resting_potential) * decay_factor;
+        membrane_potential = resting_potential +
+                            (membrane_potential - resting_potential) * state->decay_factor[index];
     }
 }
 
-void Neuron::receive_spike(double weight) {
-    // Add weighted input to membrane potential
-    membrane_potential += weight;
-}
-
 void Neuron::apply_input(double current) {
+    if (network != nullptr) {
+        network->add_input(index, current);
+        return;
+    }
+
     // Add external current to membrane potential
-    membrane_potential += current;
+    state->membrane_potential[index] += current;
+}
+
+double Neuron::get_potential() const {
+    if (network != nullptr) {
+        return network->current_potential(index);
+    }
+    return state->membrane_potential[index];
 }
 
 void Neuron::set_time_step(int time_step) {
-    if (has_spiked) {
-        last_spike_time = time_step;
-        spike_history.push_back(time_step);
-        // Keep only recent spike history (last 100 spikes)
-        if (spike_history.size() > 100) {
-            spike_history.erase(spike_history.begin());
-        }
+    if (state->has_spiked[index]) {
+        state->last_spike_time[index] = time_step;
+        state->record_spike(index, time_step);
     }
 }
 
+std::vector<int> Neuron::get_spike_history() const {
+    std::vector<int> history(state->history_size(index));
+    for (size_t k = 0; k < history.size(); ++k) {
+        history[k] = state->history_at(index, k);
+    }
+    return history;
+}
+
 void Neuron::update_stdp(int /* current_time */, double learning_rate, double tau_plus, double tau_minus) {
     // STDP: Spike-Timing Dependent Plasticity
     // If pre-synaptic neuron spikes before post-synaptic: strengthen (LTP)
     // If post-synaptic neuron spikes before post-synaptic: weaken (LTD)
-    
+
+    if (network != nullptr) {
+        network->update_stdp_row(index, learning_rate, tau_plus, tau_minus);
+        return;
+    }
+
+    const int last_spike_time = state->last_spike_time[index];
     if (last_spike_time < 0) return; // No spike history
-    
+
+    // Factors tabulated once per thread and parameter set
+    static thread_local StdpKernel kernel(learning_rate, tau_plus, tau_minus);
+    if (!kernel.matches(learning_rate, tau_plus, tau_minus)) {
+        kernel.configure(learning_rate, tau_plus, tau_minus);
+    }
+
     for (auto& conn : connections) {
         if (conn.target == nullptr) continue;
-        
+
         int post_spike_time = conn.target->get_last_spike_time();
         if (post_spike_time < 0) continue; // Post-synaptic neuron hasn't spiked
-        
-        int dt = post_spike_time - last_spike_time; // Time difference
-        
-        if (dt > 0) {
-            // Pre before post: Long-Term Potentiation (LTP)
-            double weight_change = learning_rate * exp(-dt / tau_plus);
-            conn.weight += weight_change;
-            // Clamp weight
-            if (conn.weight > 1.0) conn.weight = 1.0;
-        } else if (dt < 0) {
-            // Post before pre: Long-Term Depression (LTD)
-            double weight_change = -learning_rate * exp(dt / tau_minus);
-            conn.weight += weight_change;
-            // Clamp weight
-            if (conn.weight < 0.0) conn.weight = 0.0;
-        }
-    }
-}
 
-void Neuron::reset() {
-    membrane_potential = resting_potential;
-    has_spiked = false;
-    spike_count = 0;
-    last_spike_time = -1;
-    spike_history.clear();
+        // Pre before post: Long-Term Potentiation (LTP), clamped to 1;
+        // post before pre: Long-Term Depression (LTD), clamped to 0
+        kernel.apply(conn.weight, post_spike_time - last_spike_time);
+    }
 }
-
@@ -4,80 +4,140 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <cstdint>
 
+// Spikes kept in each neuron's spike history unless the network sets another
+// capacity
+const size_t DEFAULT_SPIKE_HISTORY_CAPACITY = 100;
+
+// Structure-of-arrays store for neuron state: one contiguous array per field,
+// indexed by neuron id. The hot fields used by every update step sit in their
+// own arrays so a network sweep streams through memory linearly; the cold
+// spike history is kept apart and only touched when a neuron spikes.
+struct NeuronState {
+    // Hot state (read/written every time step)
+    std::vector<double> membrane_potential;    // Current membrane potential
+    std::vector<double> threshold;             // Spike threshold
+    std::vector<double> resting_potential;     // Resting membrane potential
+    std::vector<double> decay_factor;          // Membrane potential decay
+    std::vector<unsigned char> has_spiked;     // Spiked in current time step
+
+    // Warm/cold state (statistics and STDP bookkeeping)
+    std::vector<int> spike_count;              // Total number of spikes
+    std::vector<int> last_spike_time;          // Last spike time step (for STDP)
+
+    // Spike times (for STDP): the last history_capacity spikes of neuron i
+    // live in a ring at spike_history[i * history_capacity], allocated up
+    // front so recording a spike never allocates. history_recorded[i] counts
+    // the spikes recorded since the last reset; the next one goes to slot
+    // history_recorded[i] % history_capacity.
+    size_t history_capacity = DEFAULT_SPIKE_HISTORY_CAPACITY;  // 0 disables the history
+    std::vector<int> spike_history;
+    std::vector<uint32_t> history_recorded;
+
+    // Resize to n neurons, initialising new entries with the given parameters
+    void resize(size_t n, double threshold = 1.0, double resting = 0.0, double decay = 0.9);
+
+    // Reset the dynamic state of neuron i (parameters are kept)
+    void reset(size_t i);
+
+    // Keep the last capacity spikes per neuron; clears every history
+    void set_history_capacity(size_t capacity);
+
+    // Append a spike of neuron i at time, dropping its oldest once full
+    void record_spike(size_t i, int time);
+
+    // Spikes in the history of neuron i, and the k-th oldest of them
+    size_t history_size(size_t i) const {
+        return history_recorded[i] < history_capacity ? history_recorded[i] : history_capacity;
+    }
+    int history_at(size_t i, size_t k) const;
+
+    size_t size() const { return membrane_potential.size(); }
+};
+
+class Network;
+
+// Lightweight handle onto one entry of a NeuronState store. Neurons owned by a
+// Network are views into the network's store and their synapses live in the
+// network's CSR synapse store; a Neuron constructed on its own owns a private
+// single-entry store and a small connection list so it can be used standalone.
 class Neuron {
 public:
-    // Connection structure to hold link to another neuron and weight
+    // Connection from a standalone neuron to another neuron
     struct Connection {
         Neuron* target;
         double weight;
-        
+
         Connection(Neuron* t, double w) : target(t), weight(w) {}
     };
 
 private:
-    double membrane_potential;      // Current membrane potential
-    double threshold;                // Spike threshold
-    double resting_potential;         // Resting membrane potential
-    double decay_factor;             // Membrane potential decay
-    std::vector<Connection> connections;  // Dynamic connections to other neurons
-    bool has_spiked;                 // Whether neuron spiked in current time step
-    int spike_count;                 // Total number of spikes
-    int last_spike_time;             // Last time step when neuron spiked (for STDP)
-    std::vector<int> spike_history;  // History of spike times (for STDP)
+    NeuronState* state;                   // Backing state store
+    size_t index;                         // Index into the state store
+    Network* network;                     // Owning network (nullptr if standalone)
+    std::unique_ptr<NeuronState> owned_state;  // Set only for standalone neurons
+    std::vector<Connection> connections;  // Connections of a standalone neuron
+
+    friend class Network;
+
+    // View constructor used by Network
+    Neuron(Network* network, NeuronState* state, size_t index);
 
 public:
     // Constructor
     Neuron(double threshold = 1.0, double resting = 0.0, double decay = 0.9);
-    
-    // Add a connection to another neuron
+
+    Neuron(Neuron&&) = default;
+    Neuron& operator=(Neuron&&) = default;
+
+    // Add a connection to another neuron (within the same network for
+    // network-owned neurons)
     void add_connection(Neuron* target, double weight);
-    
+
     // Remove a connection to a specific neuron
     void remove_connection(Neuron* target);
-    
+
     // Update neuron state (called each time step)
     void update();
-    
+
     // Receive input spike from another neuron
-    void receive_spike(double weight);
-    
+    void receive_spike(double weight) { apply_input(weight); }
+
     // Apply external input current
     void apply_input(double current);
-    
+
     // Check if neuron spiked
-    bool spiked() const { return has_spiked; }
-    
+    bool spiked() const { return state->has_spiked[index] != 0; }
+
     // Get current membrane potential
-    double get_potential() const { return membrane_potential; }
-    
+    double get_potential() const;
+
     // Get spike count
-    int get_spike_count() const { return spike_count; }
-    
+    int get_spike_count() const { return state->spike_count[index]; }
+
     // Get number of connections
-    size_t get_connection_count() const { return connections.size(); }
-    
-    // Get connections (for export/visualization)
-    const std::vector<Connection>& get_connections() const { return connections; }
-    
-    // Get mutable connections (for learning)
-    std::vector<Connection>& get_connections_mutable() { return connections; }
-    
+    size_t get_connection_count() const;
+
+    // Get number of connections into this neuron (fan-in), from the
+    // network's reverse index. Standalone neurons only know their outgoing
+    // connections and report 0.
+    size_t get_incoming_count() const;
+
     // Get last spike time
-    int get_last_spike_time() const { return last_spike_time; }
-    
-    // Get spike history
-    const std::vector<int>& get_spike_history() const { return spike_history; }
-    
+    int get_last_spike_time() const { return state->last_spike_time[index]; }
+
+    // Get spike history (oldest first)
+    std::vector<int> get_spike_history() const;
+
     // Update STDP learning rule (called after network update)
     void update_stdp(int current_time, double learning_rate = 0.01, double tau_plus = 20.0, double tau_minus = 20.0);
-    
+
     // Reset neuron state
-    void reset();
-    
+    void reset() { state->reset(index); }
+
     // Set time step (for STDP tracking)
     void set_time_step(int time_step);
 };
 
 #endif // NEURON_H
-
@@ -0,0 +1,213 @@
+#ifndef NEURON_MODELS_H
+#define NEURON_MODELS_H
+
+#include "neuron.h"
+#include "simd_kernels.h"
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Neuron model policies for the compiled engines. A model is a class
+// template over the scalar type that the engine is instantiated with
+// (CompiledNetwork<Scalar, Model>), so its step compiles into the sweep with
+// no virtual calls. Each model provides:
+//
+//   Params                    model constants (default-constructible)
+//   State                     only the per-neuron arrays the model needs
+//   init(state, source, params, n)
+//                             set up n neurons; source holds the parameters
+//                             of the Network being compiled
+//   reset(state)              back to the resting state
+//   select_kernels(state, level)
+//                             pick vector kernels for an instruction set
+//   input(state)              array synaptic and external input is added to
+//   potential(state, i)       membrane potential of neuron i
+//   fire(state, begin, count, spiked, spikes)
+//                             advance neurons [begin, begin + count) by one
+//                             step: set spiked[k] for neuron begin + k and
+//                             append the indices of the neurons that fired
+//                             to spikes in ascending order; returns the
+//                             number of spikes
+//
+// Input that arrives before a neuron's fire() in a step counts in that step,
+// as in Network::update().
+
+// Leaky integrate-and-fire, the rule Network uses: spike and reset to
+// resting at threshold, otherwise decay towards resting. Threshold, resting
+// level and decay are per neuron, copied from the source network. Runs the
+// runtime-dispatched SIMD fire kernel.
+template <typename Scalar>
+struct LIF {
+    typedef size_t (*Kernel)(Scalar*, const Scalar*, const Scalar*, const Scalar*,
+                             unsigned char*, size_t, uint32_t, uint32_t*);
+
+    struct Params {};
+
+    struct State {
+        std::vector<Scalar> potential;
+        std::vector<Scalar> threshold;
+        std::vector<Scalar> resting;
+        std::vector<Scalar> decay;
+        Kernel kernel;
+    };
+
+    static void init(State& state, const NeuronState& source, const Params&, size_t n) {
+        state.threshold.assign(source.threshold.begin(), source.threshold.begin() + n);
+        state.resting.assign(source.resting_potential.begin(), source.resting_potential.begin() + n);
+        state.decay.assign(source.decay_factor.begin(), source.decay_factor.begin() + n);
+        state.potential = state.resting;
+    }
+
+    static void reset(State& state) { state.potential = state.resting; }
+
+    static void select_kernels(State& state, SimdLevel level) {
+        select_fire_kernel(level, state.kernel);
+    }
+
+    static Scalar* input(State& state) { return state.potential.data(); }
+
+    static double potential(const State& state, size_t i) { return (double)state.potential[i]; }
+
+    static size_t fire(State& state, size_t begin, size_t count, unsigned char* spiked,
+                       uint32_t* spikes) {
+        return state.kernel(state.potential.data() + begin, state.threshold.data() + begin,
+                            state.resting.data() + begin, state.decay.data() + begin,
+                            spiked, count, (uint32_t)begin, spikes);
+    }
+};
+
+// LIF with an absolute refractory period: after a spike the neuron is held
+// at resting and ignores its input for refractory_steps steps. With
+// refractory_steps = 0 it matches LIF exactly. Runs the LIF fire kernel and
+// keeps the held neurons in a short list, so the refractory bookkeeping
+// costs O(spikes) rather than a pass over every neuron. Assumes resting
+// is below threshold, so a held neuron never fires in the kernel.
+template <typename Scalar>
+struct RefractoryLIF {
+    struct Params {
+        int refractory_steps;
+        Params() : refractory_steps(2) {}
+    };
+
+    struct State : LIF<Scalar>::State {
+        std::vector<int32_t> refractory;  // Steps left in the refractory period
+        std::vector<uint32_t> held;       // Neurons with refractory > 0
+        int32_t refractory_steps;
+    };
+
+    static void init(State& state, const NeuronState& source, const Params& params, size_t n) {
+        LIF<Scalar>::init(state, source, typename LIF<Scalar>::Params(), n);
+        state.refractory_steps = std::max(0, params.refractory_steps);
+        state.refractory.assign(n, 0);
+        state.held.clear();
+        state.held.reserve(n);  // A neuron is held at most once, so fire() never grows it
+    }
+
+    static void reset(State& state) {
+        LIF<Scalar>::reset(state);
+        for (uint32_t i : state.held) state.refractory[i] = 0;
+        state.held.clear();
+    }
+
+    static void select_kernels(State& state, SimdLevel level) {
+        LIF<Scalar>::select_kernels(state, level);
+    }
+
+    static Scalar* input(State& state) { return state.potential.data(); }
+
+    static double potential(const State& state, size_t i) { return (double)state.potential[i]; }
+
+    static size_t fire(State& state, size_t begin, size_t count, unsigned char* spiked,
+                       uint32_t* spikes) {
+        const size_t end = begin + count;
+
+        // Held neurons discard their input, so the kernel sees them at rest
+        for (uint32_t i : state.held) {
+            if (i >= begin && i < end) state.potential[i] = state.resting[i];
+        }
+
+        const size_t num_spikes = LIF<Scalar>::fire(state, begin, count, spiked, spikes);
+
+        // Count down the held neurons of this range and release finished ones
+        size_t kept = 0;
+        for (size_t h = 0; h < state.held.size(); ++h) {
+            const uint32_t i = state.held[h];
+            if (i >= begin && i < end && --state.refractory[i] == 0) continue;
+            state.held[kept++] = i;
+        }
+        state.held.resize(kept);
+
+        if (state.refractory_steps > 0) {
+            for (size_t s = 0; s < num_spikes; ++s) {
+                state.refractory[spikes[s]] = state.refractory_steps;
+                state.held.push_back(spikes[s]);
+            }
+        }
+        return num_spikes;
+    }
+};
+
+// Izhikevich (2003) two-variable model: membrane potential v (mV) and
+// recovery u, with v' = 0.04v^2 + 5v + 140 - u and u' = a(bv - u), one
+// step per time step (v in two half steps for stability). A neuron spikes
+// when v reaches peak, then v = c and u += d. The defaults are a regular
+// spiking cortical neuron. Synaptic input is a current: the weights that
+// arrive in a step are scaled by input_gain and added to v before it is
+// integrated. The source network's LIF parameters are not used. Runs the
+// runtime-dispatched SIMD Izhikevich kernel.
+template <typename Scalar>
+struct Izhikevich {
+    typedef size_t (*Kernel)(Scalar*, Scalar*, Scalar*, const IzhikevichConstants<Scalar>&,
+                             unsigned char*, size_t, uint32_t, uint32_t*);
+
+    struct Params {
+        double a, b, c, d;
+        double peak;        // Spike cutoff (mV)
+        double input_gain;  // mV per unit of synaptic weight
+        Params() : a(0.02), b(0.2), c(-65.0), d(8.0), peak(30.0), input_gain(100.0) {}
+    };
+
+    struct State {
+        std::vector<Scalar> v;
+        std::vector<Scalar> u;
+        std::vector<Scalar> current;  // Input received this step
+        IzhikevichConstants<Scalar> constants;
+        Kernel kernel;
+    };
+
+    static void init(State& state, const NeuronState&, const Params& params, size_t n) {
+        state.constants.a = (Scalar)params.a;
+        state.constants.b = (Scalar)params.b;
+        state.constants.c = (Scalar)params.c;
+        state.constants.d = (Scalar)params.d;
+        state.constants.peak = (Scalar)params.peak;
+        state.constants.gain = (Scalar)params.input_gain;
+        state.v.resize(n);
+        reset(state);
+    }
+
+    static void reset(State& state) {
+        const size_t n = state.v.size();
+        state.v.assign(n, state.constants.c);
+        state.u.assign(n, state.constants.b * state.constants.c);
+        state.current.assign(n, 0);
+    }
+
+    static void select_kernels(State& state, SimdLevel level) {
+        select_izhikevich_kernel(level, state.kernel);
+    }
+
+    static Scalar* input(State& state) { return state.current.data(); }
+
+    static double potential(const State& state, size_t i) { return (double)state.v[i]; }
+
+    static size_t fire(State& state, size_t begin, size_t count, unsigned char* spiked,
+                       uint32_t* spikes) {
+        return state.kernel(state.v.data() + begin, state.u.data() + begin,
+                            state.current.data() + begin, state.constants,
+                            spiked, count, (uint32_t)begin, spikes);
+    }
+};
+
+#endif // NEURON_MODELS_H
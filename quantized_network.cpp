@@ -0,0 +1,170 @@
+#include "quantized_network.h"
+#include "spike_delivery.h"
+#include <algorithm>
+#include <cmath>
+
+// Round value * 2^bits to the nearest integer and saturate to [lo, hi]
+static int32_t quantize(double value, int bits, int32_t lo, int32_t hi) {
+    double scaled = std::round(std::ldexp(value, bits));
+    if (scaled > hi) return hi;
+    if (scaled < lo) return lo;
+    return (int32_t)scaled;
+}
+
+QuantizationParams QuantizedNetwork::calibrate(const Network& network,
+                                               const std::vector<std::vector<double>>& input_currents,
+                                               int steps) {
+    const NeuronState& state = network.get_state();
+    const SynapseStore& synapses = network.get_synapses();
+    const size_t n = state.size();
+    const uint32_t* offsets = synapses.offsets_data();
+    const uint32_t* targets = synapses.targets_data();
+    const double* weights = synapses.weights_data();
+
+    QuantizationParams result;
+    result.max_weight = 0.0;
+    for (size_t k = 0; k < synapses.size(); ++k) {
+        result.max_weight = std::max(result.max_weight, std::fabs(weights[k]));
+    }
+    // Weights are included so a weight shifted to the potential format
+    // always fits in int16
+    result.max_potential = result.max_weight;
+    for (size_t i = 0; i < n; ++i) {
+        result.max_potential = std::max(result.max_potential, std::fabs(state.threshold[i]));
+        result.max_potential = std::max(result.max_potential, std::fabs(state.resting_potential[i]));
+    }
+
+    // Replay the time-driven chunked sweep in double precision. A chunk's
+    // potentials are inspected just before it fires, which is when they
+    // peak (all input from earlier chunks has arrived).
+    std::vector<uint32_t> chunks;
+    synapses.sweep_chunks(chunks);
+    std::vector<double> potential(n);
+    for (const std::vector<double>& currents : input_currents) {
+        potential = state.resting_potential;
+        for (size_t i = 0; i < currents.size() && i < n; ++i) {
+            potential[i] += currents[i];
+        }
+        for (int step = 0; step < steps; ++step) {
+            for (size_t c = 0; c + 1 < chunks.size(); ++c) {
+                for (size_t i = chunks[c]; i < chunks[c + 1]; ++i) {
+                    result.max_potential = std::max(result.max_potential, std::fabs(potential[i]));
+                }
+                for (size_t i = chunks[c]; i < chunks[c + 1]; ++i) {
+                    const double rest = state.resting_potential[i];
+                    if (potential[i] >= state.threshold[i]) {
+                        potential[i] = rest;
+                        for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                            potential[targets[k]] += weights[k];
+                        }
+                    } else {
+                        potential[i] = rest + (potential[i] - rest) * state.decay_factor[i];
+                    }
+                }
+            }
+        }
+    }
+
+    // Keep a factor of two of headroom over the calibrated range so unseen
+    // inputs saturate rarely, and give weights as many bits as fit in int8
+    // without exceeding the potential format
+    result.potential_bits = 14;
+    while (result.potential_bits > 0 &&
+           std::ldexp(result.max_potential * 2.0, result.potential_bits) > 32767.0) {
+        --result.potential_bits;
+    }
+    result.weight_bits = result.potential_bits;
+    while (result.weight_bits > 0 && std::ldexp(result.max_weight, result.weight_bits) > 127.0) {
+        --result.weight_bits;
+    }
+    return result;
+}
+
+QuantizedNetwork::QuantizedNetwork(const Network& network, const QuantizationParams& params)
+    : params(params), weight_shift(params.potential_bits - params.weight_bits) {
+    const NeuronState& state = network.get_state();
+    const size_t n = state.size();
+    const int bits = params.potential_bits;
+
+    potential.resize(n);
+    threshold.resize(n);
+    resting.resize(n);
+    decay.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        threshold[i] = (int16_t)quantize(state.threshold[i], bits, -32768, 32767);
+        resting[i] = (int16_t)quantize(state.resting_potential[i], bits, -32768, 32767);
+        decay[i] = (int16_t)quantize(state.decay_factor[i], 15, 0, 32767);
+    }
+    potential = resting;
+    has_spiked.assign(n, 0);
+    spike_count.assign(n, 0);
+
+    const int weight_bits = params.weight_bits;
+    synapses = std::make_shared<const SnapshotSynapses<int8_t>>(network.get_synapses(),
+        [weight_bits](double weight) { return (int8_t)quantize(weight, weight_bits, -128, 127); });
+
+    step_spikes.reserve(n);
+    set_simd_level(network.get_simd_level());
+}
+
+void QuantizedNetwork::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    fire_kernel = select_fire_kernel_fixed(level);
+    accumulate_kernel = select_accumulate_kernel_fixed(level);
+}
+
+void QuantizedNetwork::reset() {
+    potential = resting;
+    std::fill(has_spiked.begin(), has_spiked.end(), 0);
+    std::fill(spike_count.begin(), spike_count.end(), 0);
+    step_spikes.clear();
+}
+
+void QuantizedNetwork::apply_input(size_t i, double current) {
+    int32_t value = potential[i] + quantize(current, params.potential_bits, -65536, 65535);
+    potential[i] = (int16_t)std::max(-32768, std::min(32767, value));
+}
+
+double QuantizedNetwork::get_potential(size_t i) const {
+    return std::ldexp((double)potential[i], -params.potential_bits);
+}
+
+void QuantizedNetwork::update() {
+    // Same chunked sweep and dense block delivery as Network::step(), with
+    // saturating adds. The arrays are held in locals: int8_t loads may alias
+    // anything, which would otherwise force them to be reloaded after every
+    // store.
+    step_spikes.resize(size());
+    int16_t* v = potential.data();
+    const int8_t* row_weights = synapses->weights.data();
+    const SpikeRoutes routes = make_spike_routes(*synapses);
+    const int16_t* thresholds = threshold.data();
+    const int16_t* rest = resting.data();
+    const int16_t* decays = decay.data();
+    unsigned char* spiked = has_spiked.data();
+    int* counts = spike_count.data();
+    const int shift = weight_shift;
+    const FireKernelFixed fire = fire_kernel;
+    const AccumulateKernelFixed accumulate = accumulate_kernel;
+    step_spikes.resize(sweep_in_chunks(synapses->sweep_chunks, step_spikes.data(),
+        [fire, v, thresholds, rest, decays, spiked](size_t begin, size_t count, uint32_t* out) {
+            return fire(v + begin, thresholds + begin, rest + begin, decays + begin,
+                        spiked + begin, count, (uint32_t)begin, out);
+        },
+        [&routes, v, row_weights, shift, accumulate, counts](const uint32_t* spikes, size_t fired) {
+            for (size_t s = 0; s < fired; ++s) {
+                counts[spikes[s]]++;
+            }
+            route_spikes(routes, spikes, fired,
+                [v, row_weights, shift](uint32_t target, uint32_t slot) {
+                    int32_t value = v[target] + ((int32_t)row_weights[slot] << shift);
+                    v[target] = (int16_t)std::max(-32768, std::min(32767, value));
+                },
+                [v, row_weights, shift, accumulate](size_t target, size_t slot, size_t length) {
+                    accumulate(v + target, row_weights + slot, length, shift);
+                });
+        }));
+}
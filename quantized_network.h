@@ -0,0 +1,98 @@
+#ifndef QUANTIZED_NETWORK_H
+#define QUANTIZED_NETWORK_H
+
+#include "network.h"
+#include "simd_kernels.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-point formats for a QuantizedNetwork. Potentials, thresholds and
+// resting levels are int16 with potential_bits fractional bits; weights are
+// int8 with weight_bits fractional bits (weight_bits <= potential_bits, so a
+// weight is shifted left by the difference before it is added).
+struct QuantizationParams {
+    int potential_bits;
+    int weight_bits;
+    double max_potential;  // Largest |potential| seen during calibration
+    double max_weight;     // Largest |weight| in the network
+};
+
+// Integer-only, inference-only snapshot of a Network. Like CompiledNetwork it
+// runs the time-driven engine with the chunked sweep; the membrane decay is
+// a Q15 multiply-shift and every addition saturates, as on neuromorphic
+// hardware. Results approximate the double reference; how closely depends on
+// the calibration (see QuantizedNetwork::calibrate()). Copies share the
+// synapses and get their own neuron state.
+class QuantizedNetwork {
+public:
+    // Pick fixed-point formats for network by simulating it (time-driven,
+    // double precision, no learning) on each input pattern for the given
+    // number of steps and recording the largest membrane potential reached
+    // before any threshold test. input_currents[s][i] is the input applied to
+    // neuron i for pattern s. The network itself is not modified.
+    static QuantizationParams calibrate(const Network& network,
+                                        const std::vector<std::vector<double>>& input_currents,
+                                        int steps);
+
+    // Quantize the topology, weights and neuron parameters of network
+    QuantizedNetwork(const Network& network, const QuantizationParams& params);
+
+    // Get number of neurons
+    size_t size() const { return potential.size(); }
+
+    // Get total number of connections
+    size_t connection_count() const { return synapses->targets.size(); }
+
+    // Formats this network was quantized with
+    const QuantizationParams& get_params() const { return params; }
+
+    // Instruction set for the fire kernel (defaults to the best available)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset all neurons to their resting state
+    void reset();
+
+    // Apply external input current to neuron i (quantized, saturating)
+    void apply_input(size_t i, double current);
+
+    // Advance the network by one time step
+    void update();
+
+    // Spike and potential accessors
+    bool spiked(size_t i) const { return has_spiked[i] != 0; }
+    int get_spike_count(size_t i) const { return spike_count[i]; }
+    double get_potential(size_t i) const;
+
+    // Neurons that spiked in the last step, in ascending index order
+    const std::vector<uint32_t>& get_step_spikes() const { return step_spikes; }
+
+    // Bytes used by the synapse arrays (targets and weights)
+    size_t synapse_bytes() const {
+        return synapses->targets.size() * sizeof(uint32_t) + synapses->weights.size() * sizeof(int8_t);
+    }
+
+private:
+    QuantizationParams params;
+    int weight_shift;  // potential_bits - weight_bits
+
+    // Neuron state (decay is a Q15 multiplier)
+    std::vector<int16_t> potential;
+    std::vector<int16_t> threshold;
+    std::vector<int16_t> resting;
+    std::vector<int16_t> decay;
+    std::vector<unsigned char> has_spiked;
+    std::vector<int> spike_count;
+
+    // CSR synapses, the chunks the sweep fires at once and the dense blocks
+    std::shared_ptr<const SnapshotSynapses<int8_t>> synapses;
+
+    std::vector<uint32_t> step_spikes;
+    SimdLevel simd_level;
+    FireKernelFixed fire_kernel;
+    AccumulateKernelFixed accumulate_kernel;
+};
+
+#endif // QUANTIZED_NETWORK_H
@@ -0,0 +1,1048 @@
+#include "simd_kernels.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPIKE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// The decay is written as a separate multiply and add in every kernel (no
+// FMA), so the vector kernels round exactly like the scalar reference.
+
+template <typename Scalar>
+static size_t fire_scalar(Scalar* potential, const Scalar* threshold,
+                          const Scalar* resting, const Scalar* decay,
+                          unsigned char* spiked, size_t count,
+                          uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (potential[i] >= threshold[i]) {
+            spiked[i] = 1;
+            potential[i] = resting[i];
+            spikes[num_spikes++] = first_index + (uint32_t)i;
+        } else {
+            spiked[i] = 0;
+            potential[i] = resting[i] + (potential[i] - resting[i]) * decay[i];
+        }
+    }
+    return num_spikes;
+}
+
+// Saturate a 32-bit intermediate to int16
+static inline int16_t saturate_int16(int32_t value) {
+    return (int16_t)(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+}
+
+// Fixed-point kernel: potentials are int16, decay is a Q15 multiplier.
+// Decay is resting + round((potential - resting) * decay / 2^15) with
+// saturating subtract and add, which is exactly what the vector kernels
+// compute with subs/mulhrs/adds.
+static size_t fire_scalar_fixed(int16_t* potential, const int16_t* threshold,
+                                const int16_t* resting, const int16_t* decay,
+                                unsigned char* spiked, size_t count,
+                                uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (potential[i] >= threshold[i]) {
+            spiked[i] = 1;
+            potential[i] = resting[i];
+            spikes[num_spikes++] = first_index + (uint32_t)i;
+        } else {
+            spiked[i] = 0;
+            int32_t offset = saturate_int16((int32_t)potential[i] - resting[i]);
+            int32_t scaled = (offset * decay[i] + 0x4000) >> 15;
+            potential[i] = saturate_int16(resting[i] + scaled);
+        }
+    }
+    return num_spikes;
+}
+
+// Saturating add of shifted int8 weights onto a contiguous run of int16
+// potentials (one spike delivered to a block of consecutive targets)
+static void accumulate_scalar_fixed(int16_t* potential, const int8_t* weights,
+                                    size_t count, int shift) {
+    for (size_t i = 0; i < count; ++i) {
+        potential[i] = saturate_int16((int32_t)potential[i] + ((int32_t)weights[i] << shift));
+    }
+}
+
+// Add a row of weights onto a contiguous run of potentials (one spike
+// delivered to a block of consecutive targets)
+template <typename Scalar>
+static void accumulate_scalar(Scalar* potential, const Scalar* weights, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        potential[i] += weights[i];
+    }
+}
+
+// Batched delivery of one source neuron: add each weight to the lanes of
+// its target in which the source spiked
+static void batch_accumulate_scalar(double* potential, const uint32_t* targets,
+                                    const double* weights, size_t count,
+                                    const unsigned char* spiked, size_t batch) {
+    for (size_t k = 0; k < count; ++k) {
+        double* lanes = potential + (size_t)targets[k] * batch;
+        for (size_t b = 0; b < batch; ++b) {
+            if (spiked[b]) lanes[b] += weights[k];
+        }
+    }
+}
+
+// Exponential by range reduction and a polynomial: x = n * ln2 + r with
+// |r| <= ln2 / 2, e^r from its Taylor series to degree 13 in Horner form,
+// scaled by 2^n through the exponent bits. n is rounded by adding
+// 1.5 * 2^52, which leaves it in the low bits of the sum, where the vector
+// kernels pick it up the same way. Every product is rounded on its own (no
+// FMA), so all levels match this one exactly.
+static const double EXP_MIN = -708.0;
+static const double EXP_MAX = 709.0;
+static const double EXP_ROUND = 6755399441055744.0;  // 1.5 * 2^52
+static const double EXP_LOG2E = 1.4426950408889634074;
+static const double EXP_LN2_HI = 6.93147180369123816490e-01;  // n * EXP_LN2_HI is exact
+static const double EXP_LN2_LO = 1.90821492927058770002e-10;
+static const int EXP_DEGREE = 13;
+static const double EXP_COEFF[EXP_DEGREE + 1] = {
+    1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+    1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600,
+    1.0 / 6227020800.0
+};
+
+static void exp_scalar(const double* x, double* result, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const double xi = x[i];
+        const double clamped = xi < EXP_MIN ? EXP_MIN : (xi > EXP_MAX ? EXP_MAX : xi);
+        const double shifted = clamped * EXP_LOG2E + EXP_ROUND;
+        const double n = shifted - EXP_ROUND;
+        const double r = (clamped - n * EXP_LN2_HI) - n * EXP_LN2_LO;
+        double p = EXP_COEFF[EXP_DEGREE];
+        for (int c = EXP_DEGREE - 1; c >= 0; --c) {
+            p = p * r + EXP_COEFF[c];
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        bits = (bits + 1023) << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        result[i] = xi < EXP_MIN ? 0.0 : p * scale;
+    }
+}
+
+// Izhikevich model step. Every kernel evaluates the quadratic as
+// (((0.04 * v) * v + 5 * v) + 140) - u and integrates v in two half steps,
+// so the vector kernels match this one exactly.
+template <typename Scalar>
+static size_t izhikevich_scalar(Scalar* v, Scalar* u, Scalar* current,
+                                const IzhikevichConstants<Scalar>& k, unsigned char* spiked,
+                                size_t count, uint32_t first_index, uint32_t* spikes) {
+    const Scalar half = (Scalar)0.5, k2 = (Scalar)0.04, k1 = (Scalar)5, k0 = (Scalar)140;
+    size_t num_spikes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Scalar vi = v[i] + k.gain * current[i];
+        const Scalar ui = u[i];
+        current[i] = 0;
+        if (vi >= k.peak) {
+            spiked[i] = 1;
+            v[i] = k.c;
+            u[i] = ui + k.d;
+            spikes[num_spikes++] = first_index + (uint32_t)i;
+        } else {
+            spiked[i] = 0;
+            Scalar next = vi + half * (k2 * vi * vi + k1 * vi + k0 - ui);
+            next = next + half * (k2 * next * next + k1 * next + k0 - ui);
+            next = next < k.peak ? next : k.peak;  // Spike is detected next step
+            v[i] = next;
+            u[i] = ui + k.a * (k.b * next - ui);
+        }
+    }
+    return num_spikes;
+}
+
+#ifdef SPIKE_SIMD_X86
+
+// Spread the low 8 bits of mask to bit 0 of 8 consecutive bytes (x86 is
+// little-endian, so byte k holds bit k)
+static inline uint64_t spread_bits(unsigned mask) {
+    uint64_t x = mask & 0xFFu;
+    x = (x | (x << 28)) & 0x0000000F0000000FULL;
+    x = (x | (x << 14)) & 0x0003000300030003ULL;
+    x = (x | (x << 7)) & 0x0101010101010101ULL;
+    return x;
+}
+
+// Write the spike flags and spike indices for one vector of lanes
+static inline size_t emit_spikes(unsigned mask, size_t lanes, unsigned char* spiked,
+                                 uint32_t index, uint32_t* spikes) {
+    for (size_t lane = 0; lane < lanes; lane += 8) {
+        const uint64_t flags = spread_bits(mask >> lane);
+        std::memcpy(spiked + lane, &flags, lanes - lane < 8 ? lanes - lane : 8);
+    }
+    size_t num_spikes = 0;
+    while (mask != 0) {
+        spikes[num_spikes++] = index + (uint32_t)__builtin_ctz(mask);
+        mask &= mask - 1;
+    }
+    return num_spikes;
+}
+
+__attribute__((target("sse2")))
+static size_t fire_sse2(double* potential, const double* threshold,
+                        const double* resting, const double* decay,
+                        unsigned char* spiked, size_t count,
+                        uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d v = _mm_loadu_pd(potential + i);
+        __m128d r = _mm_loadu_pd(resting + i);
+        __m128d fire = _mm_cmpge_pd(v, _mm_loadu_pd(threshold + i));
+        __m128d decayed = _mm_add_pd(r, _mm_mul_pd(_mm_sub_pd(v, r), _mm_loadu_pd(decay + i)));
+        __m128d result = _mm_or_pd(_mm_and_pd(fire, r), _mm_andnot_pd(fire, decayed));
+        _mm_storeu_pd(potential + i, result);
+        num_spikes += emit_spikes((unsigned)_mm_movemask_pd(fire), 2, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+__attribute__((target("avx2")))
+static size_t fire_avx2(double* potential, const double* threshold,
+                        const double* resting, const double* decay,
+                        unsigned char* spiked, size_t count,
+                        uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d v = _mm256_loadu_pd(potential + i);
+        __m256d r = _mm256_loadu_pd(resting + i);
+        __m256d fire = _mm256_cmp_pd(v, _mm256_loadu_pd(threshold + i), _CMP_GE_OQ);
+        __m256d decayed = _mm256_add_pd(r, _mm256_mul_pd(_mm256_sub_pd(v, r),
+                                                         _mm256_loadu_pd(decay + i)));
+        _mm256_storeu_pd(potential + i, _mm256_blendv_pd(decayed, r, fire));
+        num_spikes += emit_spikes((unsigned)_mm256_movemask_pd(fire), 4, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    // Clear the upper register halves so the SSE code compiled for the
+    // baseline target that runs next does not pay the AVX/SSE transition
+    // penalty
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+__attribute__((target("avx512f")))
+static size_t fire_avx512(double* potential, const double* threshold,
+                          const double* resting, const double* decay,
+                          unsigned char* spiked, size_t count,
+                          uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d v = _mm512_loadu_pd(potential + i);
+        __m512d r = _mm512_loadu_pd(resting + i);
+        __mmask8 fire = _mm512_cmp_pd_mask(v, _mm512_loadu_pd(threshold + i), _CMP_GE_OQ);
+        // Masked forms keep the compiler from fusing these into an FMA; the
+        // add leaves firing lanes at resting, which doubles as the reset
+        __m512d scaled = _mm512_mask_mul_pd(r, (__mmask8)0xFF, _mm512_sub_pd(v, r),
+                                            _mm512_loadu_pd(decay + i));
+        _mm512_storeu_pd(potential + i, _mm512_mask_add_pd(r, (__mmask8)~fire, r, scaled));
+        num_spikes += emit_spikes((unsigned)fire, 8, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+// Single-precision kernels: same structure, twice the lanes per vector
+
+__attribute__((target("sse2")))
+static size_t fire_sse2_float(float* potential, const float* threshold,
+                              const float* resting, const float* decay,
+                              unsigned char* spiked, size_t count,
+                              uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(potential + i);
+        __m128 r = _mm_loadu_ps(resting + i);
+        __m128 fire = _mm_cmpge_ps(v, _mm_loadu_ps(threshold + i));
+        __m128 decayed = _mm_add_ps(r, _mm_mul_ps(_mm_sub_ps(v, r), _mm_loadu_ps(decay + i)));
+        __m128 result = _mm_or_ps(_mm_and_ps(fire, r), _mm_andnot_ps(fire, decayed));
+        _mm_storeu_ps(potential + i, result);
+        num_spikes += emit_spikes((unsigned)_mm_movemask_ps(fire), 4, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+__attribute__((target("avx2")))
+static size_t fire_avx2_float(float* potential, const float* threshold,
+                              const float* resting, const float* decay,
+                              unsigned char* spiked, size_t count,
+                              uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(potential + i);
+        __m256 r = _mm256_loadu_ps(resting + i);
+        __m256 fire = _mm256_cmp_ps(v, _mm256_loadu_ps(threshold + i), _CMP_GE_OQ);
+        __m256 decayed = _mm256_add_ps(r, _mm256_mul_ps(_mm256_sub_ps(v, r),
+                                                        _mm256_loadu_ps(decay + i)));
+        _mm256_storeu_ps(potential + i, _mm256_blendv_ps(decayed, r, fire));
+        num_spikes += emit_spikes((unsigned)_mm256_movemask_ps(fire), 8, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+__attribute__((target("avx512f")))
+static size_t fire_avx512_float(float* potential, const float* threshold,
+                                const float* resting, const float* decay,
+                                unsigned char* spiked, size_t count,
+                                uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_loadu_ps(potential + i);
+        __m512 r = _mm512_loadu_ps(resting + i);
+        __mmask16 fire = _mm512_cmp_ps_mask(v, _mm512_loadu_ps(threshold + i), _CMP_GE_OQ);
+        __m512 scaled = _mm512_mask_mul_ps(r, (__mmask16)0xFFFF, _mm512_sub_ps(v, r),
+                                           _mm512_loadu_ps(decay + i));
+        _mm512_storeu_ps(potential + i, _mm512_mask_add_ps(r, (__mmask16)~fire, r, scaled));
+        num_spikes += emit_spikes((unsigned)fire, 16, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar(potential + i, threshold + i, resting + i, decay + i,
+                                    spiked + i, count - i, first_index + (uint32_t)i,
+                                    spikes + num_spikes);
+}
+
+// Fixed-point kernels: 8/16/32 int16 lanes per vector. The 128-bit kernel
+// needs SSSE3 for mulhrs; the 512-bit one needs AVX-512BW.
+
+__attribute__((target("ssse3")))
+static size_t fire_ssse3_fixed(int16_t* potential, const int16_t* threshold,
+                               const int16_t* resting, const int16_t* decay,
+                               unsigned char* spiked, size_t count,
+                               uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(potential + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(resting + i));
+        __m128i quiet = _mm_cmplt_epi16(v, _mm_loadu_si128((const __m128i*)(threshold + i)));
+        __m128i scaled = _mm_mulhrs_epi16(_mm_subs_epi16(v, r),
+                                          _mm_loadu_si128((const __m128i*)(decay + i)));
+        __m128i decayed = _mm_adds_epi16(r, scaled);
+        __m128i result = _mm_or_si128(_mm_and_si128(quiet, decayed), _mm_andnot_si128(quiet, r));
+        _mm_storeu_si128((__m128i*)(potential + i), result);
+        unsigned fire = ~(unsigned)_mm_movemask_epi8(_mm_packs_epi16(quiet, zero)) & 0xFFu;
+        num_spikes += emit_spikes(fire, 8, spiked + i, first_index + (uint32_t)i,
+                                  spikes + num_spikes);
+    }
+    return num_spikes + fire_scalar_fixed(potential + i, threshold + i, resting + i, decay + i,
+                                          spiked + i, count - i, first_index + (uint32_t)i,
+                                          spikes + num_spikes);
+}
+
+__attribute__((target("avx2")))
+static size_t fire_avx2_fixed(int16_t* potential, const int16_t* threshold,
+                              const int16_t* resting, const int16_t* decay,
+                              unsigned char* spiked, size_t count,
+                              uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(potential + i));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(resting + i));
+        __m256i quiet = _mm256_cmpgt_epi16(_mm256_loadu_si256((const __m256i*)(threshold + i)), v);
+        __m256i scaled = _mm256_mulhrs_epi16(_mm256_subs_epi16(v, r),
+                                             _mm256_loadu_si256((const __m256i*)(decay + i)));
+        __m256i decayed = _mm256_adds_epi16(r, scaled);
+        _mm256_storeu_si256((__m256i*)(potential + i), _mm256_blendv_epi8(r, decayed, quiet));
+        // packs works per 128-bit half: lanes 0-7 land in bits 0-7, lanes 8-15 in bits 16-23
+        unsigned bytes = (unsigned)_mm256_movemask_epi8(_mm256_packs_epi16(quiet, zero));
+        unsigned fire = ~((bytes & 0xFFu) | ((bytes >> 8) & 0xFF00u)) & 0xFFFFu;
+        num_spikes += emit_spikes(fire, 16, spiked + i, first_index + (uint32_t)i,
+                                  spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar_fixed(potential + i, threshold + i, resting + i, decay + i,
+                                          spiked + i, count - i, first_index + (uint32_t)i,
+                                          spikes + num_spikes);
+}
+
+__attribute__((target("avx512bw")))
+static size_t fire_avx512_fixed(int16_t* potential, const int16_t* threshold,
+                                const int16_t* resting, const int16_t* decay,
+                                unsigned char* spiked, size_t count,
+                                uint32_t first_index, uint32_t* spikes) {
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m512i v = _mm512_loadu_si512(potential + i);
+        __m512i r = _mm512_loadu_si512(resting + i);
+        __mmask32 fire = _mm512_cmpge_epi16_mask(v, _mm512_loadu_si512(threshold + i));
+        __m512i scaled = _mm512_mulhrs_epi16(_mm512_subs_epi16(v, r),
+                                             _mm512_loadu_si512(decay + i));
+        __m512i decayed = _mm512_adds_epi16(r, scaled);
+        _mm512_storeu_si512(potential + i, _mm512_mask_blend_epi16(fire, decayed, r));
+        num_spikes += emit_spikes((unsigned)fire, 32, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + fire_scalar_fixed(potential + i, threshold + i, resting + i, decay + i,
+                                          spiked + i, count - i, first_index + (uint32_t)i,
+                                          spikes + num_spikes);
+}
+
+// Fixed-point accumulate kernels. The shifted weight always fits in int16
+// (QuantizedNetwork::calibrate() guarantees it), so a 16-bit shift followed
+// by a saturating add matches the scalar version.
+
+__attribute__((target("ssse3")))
+static void accumulate_ssse3_fixed(int16_t* potential, const int8_t* weights,
+                                   size_t count, int shift) {
+    const __m128i amount = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i w = _mm_loadu_si128((const __m128i*)(weights + i));
+        // Sign-extend by placing each byte in the high half and shifting back
+        __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(potential + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(potential + i + 8));
+        _mm_storeu_si128((__m128i*)(potential + i), _mm_adds_epi16(v0, _mm_sll_epi16(lo, amount)));
+        _mm_storeu_si128((__m128i*)(potential + i + 8), _mm_adds_epi16(v1, _mm_sll_epi16(hi, amount)));
+    }
+    accumulate_scalar_fixed(potential + i, weights + i, count - i, shift);
+}
+
+__attribute__((target("avx2")))
+static void accumulate_avx2_fixed(int16_t* potential, const int8_t* weights,
+                                  size_t count, int shift) {
+    const __m128i amount = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(weights + i)));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(potential + i));
+        _mm256_storeu_si256((__m256i*)(potential + i), _mm256_adds_epi16(v, _mm256_sll_epi16(w, amount)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar_fixed(potential + i, weights + i, count - i, shift);
+}
+
+__attribute__((target("avx512bw")))
+static void accumulate_avx512_fixed(int16_t* potential, const int8_t* weights,
+                                    size_t count, int shift) {
+    const __m128i amount = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m512i w = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(weights + i)));
+        __m512i v = _mm512_loadu_si512(potential + i);
+        _mm512_storeu_si512(potential + i, _mm512_adds_epi16(v, _mm512_sll_epi16(w, amount)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar_fixed(potential + i, weights + i, count - i, shift);
+}
+
+// Floating-point accumulate kernels (plain adds, so every level matches the
+// scalar loop exactly)
+
+__attribute__((target("sse2")))
+static void accumulate_sse2(double* potential, const double* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(potential + i, _mm_add_pd(_mm_loadu_pd(potential + i), _mm_loadu_pd(weights + i)));
+    }
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void accumulate_avx2(double* potential, const double* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(potential + i, _mm256_add_pd(_mm256_loadu_pd(potential + i),
+                                                      _mm256_loadu_pd(weights + i)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void accumulate_avx512(double* potential, const double* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(potential + i, _mm512_add_pd(_mm512_loadu_pd(potential + i),
+                                                      _mm512_loadu_pd(weights + i)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void accumulate_sse2_float(float* potential, const float* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(potential + i, _mm_add_ps(_mm_loadu_ps(potential + i), _mm_loadu_ps(weights + i)));
+    }
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void accumulate_avx2_float(float* potential, const float* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(potential + i, _mm256_add_ps(_mm256_loadu_ps(potential + i),
+                                                      _mm256_loadu_ps(weights + i)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void accumulate_avx512_float(float* potential, const float* weights, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(potential + i, _mm512_add_ps(_mm512_loadu_ps(potential + i),
+                                                      _mm512_loadu_ps(weights + i)));
+    }
+    _mm256_zeroupper();
+    accumulate_scalar(potential + i, weights + i, count - i);
+}
+
+// Batched delivery kernels. Lane masks are built once per call; groups of
+// lanes with no spike are skipped, and spiking lanes get a plain add, so the
+// result matches the scalar loop exactly.
+
+__attribute__((target("sse2")))
+static void batch_accumulate_sse2(double* potential, const uint32_t* targets,
+                                  const double* weights, size_t count,
+                                  const unsigned char* spiked, size_t batch) {
+    __m128d masks[MAX_BATCH_SIZE / 2];
+    bool active[MAX_BATCH_SIZE / 2];
+    const size_t groups = batch / 2;
+    for (size_t g = 0; g < groups; ++g) {
+        masks[g] = _mm_castsi128_pd(_mm_set_epi64x(-(long long)(spiked[2 * g + 1] != 0),
+                                                   -(long long)(spiked[2 * g] != 0)));
+        active[g] = spiked[2 * g] || spiked[2 * g + 1];
+    }
+    for (size_t k = 0; k < count; ++k) {
+        double* lanes = potential + (size_t)targets[k] * batch;
+        const __m128d w = _mm_set1_pd(weights[k]);
+        for (size_t g = 0; g < groups; ++g) {
+            if (!active[g]) continue;
+            __m128d v = _mm_loadu_pd(lanes + 2 * g);
+            __m128d sum = _mm_add_pd(v, w);
+            _mm_storeu_pd(lanes + 2 * g, _mm_or_pd(_mm_and_pd(masks[g], sum),
+                                                   _mm_andnot_pd(masks[g], v)));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void batch_accumulate_avx2(double* potential, const uint32_t* targets,
+                                  const double* weights, size_t count,
+                                  const unsigned char* spiked, size_t batch) {
+    __m256d masks[MAX_BATCH_SIZE / 4];
+    bool active[MAX_BATCH_SIZE / 4];
+    const size_t groups = batch / 4;
+    for (size_t g = 0; g < groups; ++g) {
+        const unsigned char* s = spiked + 4 * g;
+        masks[g] = _mm256_castsi256_pd(_mm256_set_epi64x(-(long long)(s[3] != 0), -(long long)(s[2] != 0),
+                                                         -(long long)(s[1] != 0), -(long long)(s[0] != 0)));
+        active[g] = s[0] || s[1] || s[2] || s[3];
+    }
+    for (size_t k = 0; k < count; ++k) {
+        double* lanes = potential + (size_t)targets[k] * batch;
+        const __m256d w = _mm256_set1_pd(weights[k]);
+        for (size_t g = 0; g < groups; ++g) {
+            if (!active[g]) continue;
+            __m256d v = _mm256_loadu_pd(lanes + 4 * g);
+            _mm256_storeu_pd(lanes + 4 * g, _mm256_blendv_pd(v, _mm256_add_pd(v, w), masks[g]));
+        }
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void batch_accumulate_avx512(double* potential, const uint32_t* targets,
+                                    const double* weights, size_t count,
+                                    const unsigned char* spiked, size_t batch) {
+    __mmask8 masks[MAX_BATCH_SIZE / 8];
+    const size_t groups = batch / 8;
+    for (size_t g = 0; g < groups; ++g) {
+        unsigned mask = 0;
+        for (size_t b = 0; b < 8; ++b) {
+            mask |= (unsigned)(spiked[8 * g + b] != 0) << b;
+        }
+        masks[g] = (__mmask8)mask;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        double* lanes = potential + (size_t)targets[k] * batch;
+        const __m512d w = _mm512_set1_pd(weights[k]);
+        for (size_t g = 0; g < groups; ++g) {
+            if (!masks[g]) continue;
+            __m512d v = _mm512_loadu_pd(lanes + 8 * g);
+            _mm512_storeu_pd(lanes + 8 * g, _mm512_mask_add_pd(v, masks[g], v, w));
+        }
+    }
+    _mm256_zeroupper();
+}
+
+// Izhikevich kernels. Firing lanes are computed like the others and then
+// replaced by the reset values. The AVX-512 versions use masked multiplies
+// so the compiler cannot fuse them into FMAs.
+
+__attribute__((target("avx2")))
+static inline __m256d izhikevich_half_step_avx2(__m256d x, __m256d u) {
+    __m256d t = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.04), x), x);
+    t = _mm256_add_pd(t, _mm256_mul_pd(_mm256_set1_pd(5.0), x));
+    t = _mm256_sub_pd(_mm256_add_pd(t, _mm256_set1_pd(140.0)), u);
+    return _mm256_add_pd(x, _mm256_mul_pd(_mm256_set1_pd(0.5), t));
+}
+
+__attribute__((target("avx2")))
+static size_t izhikevich_avx2(double* v, double* u, double* current,
+                              const IzhikevichConstants<double>& k, unsigned char* spiked,
+                              size_t count, uint32_t first_index, uint32_t* spikes) {
+    const __m256d a = _mm256_set1_pd(k.a), b = _mm256_set1_pd(k.b);
+    const __m256d c = _mm256_set1_pd(k.c), d = _mm256_set1_pd(k.d);
+    const __m256d peak = _mm256_set1_pd(k.peak), gain = _mm256_set1_pd(k.gain);
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d vi = _mm256_add_pd(_mm256_loadu_pd(v + i),
+                                   _mm256_mul_pd(gain, _mm256_loadu_pd(current + i)));
+        __m256d ui = _mm256_loadu_pd(u + i);
+        _mm256_storeu_pd(current + i, _mm256_setzero_pd());
+        __m256d fire = _mm256_cmp_pd(vi, peak, _CMP_GE_OQ);
+        __m256d next = izhikevich_half_step_avx2(izhikevich_half_step_avx2(vi, ui), ui);
+        next = _mm256_min_pd(next, peak);
+        __m256d recovered = _mm256_add_pd(ui, _mm256_mul_pd(a, _mm256_sub_pd(_mm256_mul_pd(b, next), ui)));
+        _mm256_storeu_pd(v + i, _mm256_blendv_pd(next, c, fire));
+        _mm256_storeu_pd(u + i, _mm256_blendv_pd(recovered, _mm256_add_pd(ui, d), fire));
+        num_spikes += emit_spikes((unsigned)_mm256_movemask_pd(fire), 4, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + izhikevich_scalar(v + i, u + i, current + i, k, spiked + i, count - i,
+                                          first_index + (uint32_t)i, spikes + num_spikes);
+}
+
+__attribute__((target("avx2")))
+static inline __m256 izhikevich_half_step_avx2_float(__m256 x, __m256 u) {
+    __m256 t = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.04f), x), x);
+    t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_set1_ps(5.0f), x));
+    t = _mm256_sub_ps(_mm256_add_ps(t, _mm256_set1_ps(140.0f)), u);
+    return _mm256_add_ps(x, _mm256_mul_ps(_mm256_set1_ps(0.5f), t));
+}
+
+__attribute__((target("avx2")))
+static size_t izhikevich_avx2_float(float* v, float* u, float* current,
+                                    const IzhikevichConstants<float>& k, unsigned char* spiked,
+                                    size_t count, uint32_t first_index, uint32_t* spikes) {
+    const __m256 a = _mm256_set1_ps(k.a), b = _mm256_set1_ps(k.b);
+    const __m256 c = _mm256_set1_ps(k.c), d = _mm256_set1_ps(k.d);
+    const __m256 peak = _mm256_set1_ps(k.peak), gain = _mm256_set1_ps(k.gain);
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vi = _mm256_add_ps(_mm256_loadu_ps(v + i),
+                                  _mm256_mul_ps(gain, _mm256_loadu_ps(current + i)));
+        __m256 ui = _mm256_loadu_ps(u + i);
+        _mm256_storeu_ps(current + i, _mm256_setzero_ps());
+        __m256 fire = _mm256_cmp_ps(vi, peak, _CMP_GE_OQ);
+        __m256 next = izhikevich_half_step_avx2_float(izhikevich_half_step_avx2_float(vi, ui), ui);
+        next = _mm256_min_ps(next, peak);
+        __m256 recovered = _mm256_add_ps(ui, _mm256_mul_ps(a, _mm256_sub_ps(_mm256_mul_ps(b, next), ui)));
+        _mm256_storeu_ps(v + i, _mm256_blendv_ps(next, c, fire));
+        _mm256_storeu_ps(u + i, _mm256_blendv_ps(recovered, _mm256_add_ps(ui, d), fire));
+        num_spikes += emit_spikes((unsigned)_mm256_movemask_ps(fire), 8, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + izhikevich_scalar(v + i, u + i, current + i, k, spiked + i, count - i,
+                                          first_index + (uint32_t)i, spikes + num_spikes);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d mul_unfused_avx512(__m512d x, __m512d y) {
+    return _mm512_mask_mul_pd(x, (__mmask8)0xFF, x, y);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d izhikevich_half_step_avx512(__m512d x, __m512d u) {
+    __m512d t = mul_unfused_avx512(mul_unfused_avx512(_mm512_set1_pd(0.04), x), x);
+    t = _mm512_add_pd(t, mul_unfused_avx512(_mm512_set1_pd(5.0), x));
+    t = _mm512_sub_pd(_mm512_add_pd(t, _mm512_set1_pd(140.0)), u);
+    return _mm512_add_pd(x, mul_unfused_avx512(_mm512_set1_pd(0.5), t));
+}
+
+__attribute__((target("avx512f")))
+static size_t izhikevich_avx512(double* v, double* u, double* current,
+                                const IzhikevichConstants<double>& k, unsigned char* spiked,
+                                size_t count, uint32_t first_index, uint32_t* spikes) {
+    const __m512d a = _mm512_set1_pd(k.a), b = _mm512_set1_pd(k.b);
+    const __m512d c = _mm512_set1_pd(k.c), d = _mm512_set1_pd(k.d);
+    const __m512d peak = _mm512_set1_pd(k.peak), gain = _mm512_set1_pd(k.gain);
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d vi = _mm512_add_pd(_mm512_loadu_pd(v + i),
+                                   mul_unfused_avx512(gain, _mm512_loadu_pd(current + i)));
+        __m512d ui = _mm512_loadu_pd(u + i);
+        _mm512_storeu_pd(current + i, _mm512_setzero_pd());
+        __mmask8 fire = _mm512_cmp_pd_mask(vi, peak, _CMP_GE_OQ);
+        __m512d next = izhikevich_half_step_avx512(izhikevich_half_step_avx512(vi, ui), ui);
+        next = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(next, peak, _CMP_LT_OQ), peak, next);
+        __m512d recovered = _mm512_add_pd(ui, mul_unfused_avx512(a, _mm512_sub_pd(
+                                                  mul_unfused_avx512(b, next), ui)));
+        _mm512_storeu_pd(v + i, _mm512_mask_blend_pd(fire, next, c));
+        _mm512_storeu_pd(u + i, _mm512_mask_blend_pd(fire, recovered, _mm512_add_pd(ui, d)));
+        num_spikes += emit_spikes((unsigned)fire, 8, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + izhikevich_scalar(v + i, u + i, current + i, k, spiked + i, count - i,
+                                          first_index + (uint32_t)i, spikes + num_spikes);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 mul_unfused_avx512_float(__m512 x, __m512 y) {
+    return _mm512_mask_mul_ps(x, (__mmask16)0xFFFF, x, y);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 izhikevich_half_step_avx512_float(__m512 x, __m512 u) {
+    __m512 t = mul_unfused_avx512_float(mul_unfused_avx512_float(_mm512_set1_ps(0.04f), x), x);
+    t = _mm512_add_ps(t, mul_unfused_avx512_float(_mm512_set1_ps(5.0f), x));
+    t = _mm512_sub_ps(_mm512_add_ps(t, _mm512_set1_ps(140.0f)), u);
+    return _mm512_add_ps(x, mul_unfused_avx512_float(_mm512_set1_ps(0.5f), t));
+}
+
+__attribute__((target("avx512f")))
+static size_t izhikevich_avx512_float(float* v, float* u, float* current,
+                                      const IzhikevichConstants<float>& k, unsigned char* spiked,
+                                      size_t count, uint32_t first_index, uint32_t* spikes) {
+    const __m512 a = _mm512_set1_ps(k.a), b = _mm512_set1_ps(k.b);
+    const __m512 c = _mm512_set1_ps(k.c), d = _mm512_set1_ps(k.d);
+    const __m512 peak = _mm512_set1_ps(k.peak), gain = _mm512_set1_ps(k.gain);
+    size_t num_spikes = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 vi = _mm512_add_ps(_mm512_loadu_ps(v + i),
+                                  mul_unfused_avx512_float(gain, _mm512_loadu_ps(current + i)));
+        __m512 ui = _mm512_loadu_ps(u + i);
+        _mm512_storeu_ps(current + i, _mm512_setzero_ps());
+        __mmask16 fire = _mm512_cmp_ps_mask(vi, peak, _CMP_GE_OQ);
+        __m512 next = izhikevich_half_step_avx512_float(izhikevich_half_step_avx512_float(vi, ui), ui);
+        next = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(next, peak, _CMP_LT_OQ), peak, next);
+        __m512 recovered = _mm512_add_ps(ui, mul_unfused_avx512_float(a, _mm512_sub_ps(
+                                                 mul_unfused_avx512_float(b, next), ui)));
+        _mm512_storeu_ps(v + i, _mm512_mask_blend_ps(fire, next, c));
+        _mm512_storeu_ps(u + i, _mm512_mask_blend_ps(fire, recovered, _mm512_add_ps(ui, d)));
+        num_spikes += emit_spikes((unsigned)fire, 16, spiked + i,
+                                  first_index + (uint32_t)i, spikes + num_spikes);
+    }
+    _mm256_zeroupper();
+    return num_spikes + izhikevich_scalar(v + i, u + i, current + i, k, spiked + i, count - i,
+                                          first_index + (uint32_t)i, spikes + num_spikes);
+}
+
+// Exponential kernels: the steps of exp_scalar() on 2, 4 and 8 lanes
+
+__attribute__((target("sse2")))
+static void exp_sse2(const double* x, double* result, size_t count) {
+    const __m128d lo = _mm_set1_pd(EXP_MIN), hi = _mm_set1_pd(EXP_MAX);
+    const __m128d round = _mm_set1_pd(EXP_ROUND), log2e = _mm_set1_pd(EXP_LOG2E);
+    const __m128d ln2_hi = _mm_set1_pd(EXP_LN2_HI), ln2_lo = _mm_set1_pd(EXP_LN2_LO);
+    const __m128i bias = _mm_set1_epi64x(1023);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d xi = _mm_loadu_pd(x + i);
+        __m128d clamped = _mm_min_pd(_mm_max_pd(xi, lo), hi);
+        __m128d shifted = _mm_add_pd(_mm_mul_pd(clamped, log2e), round);
+        __m128d n = _mm_sub_pd(shifted, round);
+        __m128d r = _mm_sub_pd(_mm_sub_pd(clamped, _mm_mul_pd(n, ln2_hi)), _mm_mul_pd(n, ln2_lo));
+        __m128d p = _mm_set1_pd(EXP_COEFF[EXP_DEGREE]);
+        for (int c = EXP_DEGREE - 1; c >= 0; --c) {
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(EXP_COEFF[c]));
+        }
+        __m128i bits = _mm_slli_epi64(_mm_add_epi64(_mm_castpd_si128(shifted), bias), 52);
+        __m128d value = _mm_mul_pd(p, _mm_castsi128_pd(bits));
+        _mm_storeu_pd(result + i, _mm_and_pd(value, _mm_cmpge_pd(xi, lo)));
+    }
+    exp_scalar(x + i, result + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void exp_avx2(const double* x, double* result, size_t count) {
+    const __m256d lo = _mm256_set1_pd(EXP_MIN), hi = _mm256_set1_pd(EXP_MAX);
+    const __m256d round = _mm256_set1_pd(EXP_ROUND), log2e = _mm256_set1_pd(EXP_LOG2E);
+    const __m256d ln2_hi = _mm256_set1_pd(EXP_LN2_HI), ln2_lo = _mm256_set1_pd(EXP_LN2_LO);
+    const __m256i bias = _mm256_set1_epi64x(1023);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d xi = _mm256_loadu_pd(x + i);
+        __m256d clamped = _mm256_min_pd(_mm256_max_pd(xi, lo), hi);
+        __m256d shifted = _mm256_add_pd(_mm256_mul_pd(clamped, log2e), round);
+        __m256d n = _mm256_sub_pd(shifted, round);
+        __m256d r = _mm256_sub_pd(_mm256_sub_pd(clamped, _mm256_mul_pd(n, ln2_hi)),
+                                  _mm256_mul_pd(n, ln2_lo));
+        __m256d p = _mm256_set1_pd(EXP_COEFF[EXP_DEGREE]);
+        for (int c = EXP_DEGREE - 1; c >= 0; --c) {
+            p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(EXP_COEFF[c]));
+        }
+        __m256i bits = _mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(shifted), bias), 52);
+        __m256d value = _mm256_mul_pd(p, _mm256_castsi256_pd(bits));
+        _mm256_storeu_pd(result + i, _mm256_and_pd(value, _mm256_cmp_pd(xi, lo, _CMP_GE_OQ)));
+    }
+    _mm256_zeroupper();
+    exp_scalar(x + i, result + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void exp_avx512(const double* x, double* result, size_t count) {
+    const __m512d lo = _mm512_set1_pd(EXP_MIN), hi = _mm512_set1_pd(EXP_MAX);
+    const __m512d round = _mm512_set1_pd(EXP_ROUND), log2e = _mm512_set1_pd(EXP_LOG2E);
+    const __m512d ln2_hi = _mm512_set1_pd(EXP_LN2_HI), ln2_lo = _mm512_set1_pd(EXP_LN2_LO);
+    const __m512i bias = _mm512_set1_epi64(1023);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d xi = _mm512_loadu_pd(x + i);
+        __mmask8 below = _mm512_cmp_pd_mask(xi, lo, _CMP_LT_OQ);
+        __m512d clamped = _mm512_mask_blend_pd(below, xi, lo);
+        clamped = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(clamped, hi, _CMP_GT_OQ), clamped, hi);
+        __m512d shifted = _mm512_add_pd(mul_unfused_avx512(clamped, log2e), round);
+        __m512d n = _mm512_sub_pd(shifted, round);
+        __m512d r = _mm512_sub_pd(_mm512_sub_pd(clamped, mul_unfused_avx512(n, ln2_hi)),
+                                  mul_unfused_avx512(n, ln2_lo));
+        __m512d p = _mm512_set1_pd(EXP_COEFF[EXP_DEGREE]);
+        for (int c = EXP_DEGREE - 1; c >= 0; --c) {
+            p = _mm512_add_pd(mul_unfused_avx512(p, r), _mm512_set1_pd(EXP_COEFF[c]));
+        }
+        // Masked and blended forms throughout: GCC's unmasked min, max and
+        // shift wrappers trip -Wmaybe-uninitialized
+        __m512i bits = _mm512_maskz_slli_epi64((__mmask8)0xFF,
+                                               _mm512_add_epi64(_mm512_castpd_si512(shifted), bias), 52);
+        __m512d value = mul_unfused_avx512(p, _mm512_castsi512_pd(bits));
+        _mm512_storeu_pd(result + i, _mm512_maskz_mov_pd((__mmask8)~below, value));
+    }
+    _mm256_zeroupper();
+    exp_scalar(x + i, result + i, count - i);
+}
+
+#endif // SPIKE_SIMD_X86
+
+SimdLevel detect_simd_level() {
+#ifdef SPIKE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+FireKernel select_fire_kernel(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    // Never hand out a kernel the CPU cannot run
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return fire_avx512;
+        case SimdLevel::AVX2: return fire_avx2;
+        case SimdLevel::SSE2: return fire_sse2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return fire_scalar<double>;
+}
+
+FireKernelFloat select_fire_kernel_float(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return fire_avx512_float;
+        case SimdLevel::AVX2: return fire_avx2_float;
+        case SimdLevel::SSE2: return fire_sse2_float;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return fire_scalar<float>;
+}
+
+FireKernelFixed select_fire_kernel_fixed(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    // The integer kernels need AVX-512BW and SSSE3 on top of the base levels
+    if (level == SimdLevel::AVX512 && !__builtin_cpu_supports("avx512bw")) {
+        level = SimdLevel::AVX2;
+    }
+    switch (level) {
+        case SimdLevel::AVX512: return fire_avx512_fixed;
+        case SimdLevel::AVX2: return fire_avx2_fixed;
+        case SimdLevel::SSE2:
+            if (__builtin_cpu_supports("ssse3")) return fire_ssse3_fixed;
+            break;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return fire_scalar_fixed;
+}
+
+AccumulateKernelFixed select_accumulate_kernel_fixed(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    if (level == SimdLevel::AVX512 && !__builtin_cpu_supports("avx512bw")) {
+        level = SimdLevel::AVX2;
+    }
+    switch (level) {
+        case SimdLevel::AVX512: return accumulate_avx512_fixed;
+        case SimdLevel::AVX2: return accumulate_avx2_fixed;
+        case SimdLevel::SSE2:
+            if (__builtin_cpu_supports("ssse3")) return accumulate_ssse3_fixed;
+            break;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return accumulate_scalar_fixed;
+}
+
+AccumulateKernel select_accumulate_kernel(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return accumulate_avx512;
+        case SimdLevel::AVX2: return accumulate_avx2;
+        case SimdLevel::SSE2: return accumulate_sse2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return accumulate_scalar<double>;
+}
+
+AccumulateKernelFloat select_accumulate_kernel_float(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return accumulate_avx512_float;
+        case SimdLevel::AVX2: return accumulate_avx2_float;
+        case SimdLevel::SSE2: return accumulate_sse2_float;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return accumulate_scalar<float>;
+}
+
+BatchAccumulateKernel select_batch_accumulate_kernel(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return batch_accumulate_avx512;
+        case SimdLevel::AVX2: return batch_accumulate_avx2;
+        case SimdLevel::SSE2: return batch_accumulate_sse2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return batch_accumulate_scalar;
+}
+
+IzhikevichKernel select_izhikevich_kernel(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    // No SSE2 version: the 2-lane kernel is barely ahead of the scalar one
+    switch (level) {
+        case SimdLevel::AVX512: return izhikevich_avx512;
+        case SimdLevel::AVX2: return izhikevich_avx2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return izhikevich_scalar<double>;
+}
+
+IzhikevichKernelFloat select_izhikevich_kernel_float(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return izhikevich_avx512_float;
+        case SimdLevel::AVX2: return izhikevich_avx2_float;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return izhikevich_scalar<float>;
+}
+
+ExpKernel select_exp_kernel(SimdLevel level) {
+#ifdef SPIKE_SIMD_X86
+    SimdLevel supported = detect_simd_level();
+    if ((int)level > (int)supported) level = supported;
+
+    switch (level) {
+        case SimdLevel::AVX512: return exp_avx512;
+        case SimdLevel::AVX2: return exp_avx2;
+        case SimdLevel::SSE2: return exp_sse2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return exp_scalar;
+}
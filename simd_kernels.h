@@ -0,0 +1,129 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Instruction set used by the vectorized neuron kernels
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Best level supported by the CPU we are running on
+SimdLevel detect_simd_level();
+
+// Human-readable name ("scalar", "sse2", "avx2", "avx512")
+const char* simd_level_name(SimdLevel level);
+
+// Fire kernel: for each of the count neurons starting at the given pointers,
+// spike if potential >= threshold (reset to resting) or decay towards
+// resting otherwise, set the spiked flag, and append the index
+// (first_index + offset) of every spiking neuron to spikes in ascending
+// order. Returns the number of spikes written. All levels of the same
+// precision produce bit-identical results.
+typedef size_t (*FireKernel)(double* potential, const double* threshold,
+                             const double* resting, const double* decay,
+                             unsigned char* spiked, size_t count,
+                             uint32_t first_index, uint32_t* spikes);
+
+// Single-precision fire kernel (twice the lanes per vector)
+typedef size_t (*FireKernelFloat)(float* potential, const float* threshold,
+                                  const float* resting, const float* decay,
+                                  unsigned char* spiked, size_t count,
+                                  uint32_t first_index, uint32_t* spikes);
+
+// Fixed-point fire kernel: int16 potentials, thresholds and resting levels,
+// decay given as a Q15 multiplier (decay * 2^15), applied as a rounding
+// multiply-shift with saturating arithmetic
+typedef size_t (*FireKernelFixed)(int16_t* potential, const int16_t* threshold,
+                                  const int16_t* resting, const int16_t* decay,
+                                  unsigned char* spiked, size_t count,
+                                  uint32_t first_index, uint32_t* spikes);
+
+// Delivery of one spike to count consecutive targets:
+// potential[i] += weights[i]
+typedef void (*AccumulateKernel)(double* potential, const double* weights, size_t count);
+typedef void (*AccumulateKernelFloat)(float* potential, const float* weights, size_t count);
+
+// Fixed-point delivery of one spike to count consecutive targets:
+// potential[i] = saturate(potential[i] + (weights[i] << shift)). The shifted
+// weights must fit in int16.
+typedef void (*AccumulateKernelFixed)(int16_t* potential, const int8_t* weights,
+                                      size_t count, int shift);
+
+// Constants of the Izhikevich model (see neuron_models.h)
+template <typename Scalar>
+struct IzhikevichConstants {
+    Scalar a, b, c, d;
+    Scalar peak;  // Spike cutoff
+    Scalar gain;  // Scale of the input current
+};
+
+// Izhikevich kernel: for each of the count neurons, add gain * current to v
+// and clear current; spike if v >= peak (v = c, u += d), otherwise integrate
+// v in two half steps (capped at peak) and then u. Sets the spiked flags and
+// appends spike indices like FireKernel; all levels are bit-identical.
+typedef size_t (*IzhikevichKernel)(double* v, double* u, double* current,
+                                   const IzhikevichConstants<double>& constants,
+                                   unsigned char* spiked, size_t count,
+                                   uint32_t first_index, uint32_t* spikes);
+typedef size_t (*IzhikevichKernelFloat)(float* v, float* u, float* current,
+                                        const IzhikevichConstants<float>& constants,
+                                        unsigned char* spiked, size_t count,
+                                        uint32_t first_index, uint32_t* spikes);
+
+// Largest batch the batched kernels accept (lanes per neuron)
+const size_t MAX_BATCH_SIZE = 256;
+
+// Batched delivery of the spikes of one source neuron. State is stored
+// neuron-major with batch lanes per neuron (lane b of neuron t at
+// potential[t * batch + b]); for each of the count synapses, weights[k] is
+// added to every lane of target targets[k] whose spiked[b] flag is set.
+// batch must be a multiple of 8 and at most MAX_BATCH_SIZE.
+typedef void (*BatchAccumulateKernel)(double* potential, const uint32_t* targets,
+                                      const double* weights, size_t count,
+                                      const unsigned char* spiked, size_t batch);
+
+// Vectorized exponential: result[i] = e^x[i] for count values, by range
+// reduction and a polynomial (within a few ulp of std::exp). Inputs above
+// 709 give e^709, inputs below -708 give 0; x must not hold NaNs. result may
+// be x itself. All levels are bit-identical.
+typedef void (*ExpKernel)(const double* x, double* result, size_t count);
+
+// Kernel for the given level (falls back to a lower level if the CPU or
+// compiler does not support it)
+FireKernel select_fire_kernel(SimdLevel level);
+FireKernelFloat select_fire_kernel_float(SimdLevel level);
+FireKernelFixed select_fire_kernel_fixed(SimdLevel level);
+AccumulateKernel select_accumulate_kernel(SimdLevel level);
+AccumulateKernelFloat select_accumulate_kernel_float(SimdLevel level);
+BatchAccumulateKernel select_batch_accumulate_kernel(SimdLevel level);
+AccumulateKernelFixed select_accumulate_kernel_fixed(SimdLevel level);
+IzhikevichKernel select_izhikevich_kernel(SimdLevel level);
+IzhikevichKernelFloat select_izhikevich_kernel_float(SimdLevel level);
+ExpKernel select_exp_kernel(SimdLevel level);
+
+// Overloads picking the kernel by type, for code templated on the scalar type
+inline void select_fire_kernel(SimdLevel level, FireKernel& kernel) {
+    kernel = select_fire_kernel(level);
+}
+inline void select_fire_kernel(SimdLevel level, FireKernelFloat& kernel) {
+    kernel = select_fire_kernel_float(level);
+}
+inline void select_accumulate_kernel(SimdLevel level, AccumulateKernel& kernel) {
+    kernel = select_accumulate_kernel(level);
+}
+inline void select_accumulate_kernel(SimdLevel level, AccumulateKernelFloat& kernel) {
+    kernel = select_accumulate_kernel_float(level);
+}
+inline void select_izhikevich_kernel(SimdLevel level, IzhikevichKernel& kernel) {
+    kernel = select_izhikevich_kernel(level);
+}
+inline void select_izhikevich_kernel(SimdLevel level, IzhikevichKernelFloat& kernel) {
+    kernel = select_izhikevich_kernel_float(level);
+}
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,167 @@
+#ifndef SPIKE_DELIVERY_H
+#define SPIKE_DELIVERY_H
+
+#include "synapse_store.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Spike delivery shared by every engine (Network, SimulationState,
+// LearningState, CompiledNetwork, QuantizedNetwork). The loops walk the raw
+// topology arrays and leave the arithmetic to callbacks, so one engine can
+// add doubles, another saturate int16 potentials, a third load shared
+// weights atomically, while the sweep order, dense block batching and delay
+// scheduling exist once.
+
+// Topology an engine delivers spikes over: CSR rows, per-synapse delays and
+// the dense blocks found by SynapseStore::dense_blocks(). Weights are not
+// part of it; callbacks get the slot of each synapse and read their own.
+struct SpikeRoutes {
+    const uint32_t* offsets;
+    const uint32_t* targets;
+    const uint8_t* delays;  // Null when every synapse has delay 1
+    const DenseBlock* dense_blocks;
+    const int32_t* dense_block_of_row;
+};
+
+// Routes over store with the dense blocks an engine derived from it
+inline SpikeRoutes make_spike_routes(const SynapseStore& store, const std::vector<DenseBlock>& blocks,
+                                     const std::vector<int32_t>& block_of_row) {
+    SpikeRoutes routes = {store.offsets_data(), store.targets_data(),
+                          store.max_delay() > 1 ? store.delays_data() : nullptr,
+                          blocks.data(), block_of_row.data()};
+    return routes;
+}
+
+// Routes over a snapshot, with delays (null when every synapse has delay 1)
+template <typename Weight>
+inline SpikeRoutes make_spike_routes(const SnapshotSynapses<Weight>& synapses,
+                                     const uint8_t* delays = nullptr) {
+    SpikeRoutes routes = {synapses.offsets.data(), synapses.targets.data(), delays,
+                          synapses.dense_blocks.data(), synapses.dense_block_of_row.data()};
+    return routes;
+}
+
+// Number of targets a dense block is processed in at a time, so the slice of
+// potentials being accumulated stays in L1 while every spiking row streams
+// over it
+const size_t DENSE_TILE_SIZE = 1024;
+
+// Spike-gated dense propagation (sparse spike vector times dense matrix):
+// for every spiking source in spikes[0, count) -- all inside block, ascending
+// -- call accumulate(target, slot, length) to add weights [slot, slot+length)
+// onto targets [target, target+length). Targets are visited in tiles; each
+// target still receives its inputs in spike order, so the result matches
+// delivering the spikes one by one.
+template <typename Accumulate>
+inline void propagate_dense_block(const DenseBlock& block, const uint32_t* spikes, size_t count,
+                                  Accumulate accumulate) {
+    const size_t width = block.width();
+    for (size_t tile = 0; tile < width; tile += DENSE_TILE_SIZE) {
+        const size_t length = width - tile < DENSE_TILE_SIZE ? width - tile : DENSE_TILE_SIZE;
+        for (size_t s = 0; s < count; ++s) {
+            const size_t slot = block.first_slot + (spikes[s] - block.source_begin) * width + tile;
+            accumulate(block.target_begin + tile, slot, length);
+        }
+    }
+}
+
+// Deliver the delay-1 synapses of spikes[0, count) (ascending): rows of a
+// dense block go through propagate_dense_block() with accumulate(target,
+// slot, length), all spiking rows of the block at once; every other synapse
+// calls add(target, slot). Synapses with a longer delay are left to
+// route_delayed_spikes().
+template <typename Add, typename Accumulate>
+inline void route_spikes(const SpikeRoutes& routes, const uint32_t* spikes, size_t count,
+                         Add add, Accumulate accumulate) {
+    const uint32_t* offsets = routes.offsets;
+    const uint32_t* targets = routes.targets;
+    const uint8_t* delays = routes.delays;
+    const int32_t* dense_block_of_row = routes.dense_block_of_row;
+
+    size_t s = 0;
+    while (s < count) {
+        const uint32_t i = spikes[s];
+        const int32_t b = dense_block_of_row[i];
+        if (b < 0) {
+            const uint32_t end = offsets[i + 1];
+            if (delays == nullptr) {
+                for (uint32_t k = offsets[i]; k < end; ++k) {
+                    add(targets[k], k);
+                }
+            } else {
+                for (uint32_t k = offsets[i]; k < end; ++k) {
+                    if (delays[k] == 1) add(targets[k], k);
+                }
+            }
+            ++s;
+            continue;
+        }
+
+        // Spikes are ascending, so the sources of one block form a run
+        const DenseBlock& block = routes.dense_blocks[b];
+        size_t run_end = s + 1;
+        while (run_end < count && spikes[run_end] < block.source_end) ++run_end;
+        propagate_dense_block(block, spikes + s, run_end - s, accumulate);
+        s = run_end;
+    }
+}
+
+// Step at which a spike of source in step t reaches target over a synapse
+// with the given delay. With sweep_order (time- and event-driven engines) a
+// target after the source is due one step earlier, since the sequential
+// sweep delivers delay 1 to such targets in step t itself.
+inline int delayed_due(int t, int delay, uint32_t source, uint32_t target, bool sweep_order) {
+    return t + delay - ((sweep_order && target > source) ? 1 : 0);
+}
+
+// Queue the delay > 1 synapses of spikes[0, count), fired in step t:
+// schedule(target, slot, due) for each, due as delayed_due(). Does nothing
+// when routes has no delays.
+template <typename Schedule>
+inline void route_delayed_spikes(const SpikeRoutes& routes, const uint32_t* spikes, size_t count,
+                                 int t, bool sweep_order, Schedule schedule) {
+    const uint32_t* offsets = routes.offsets;
+    const uint32_t* targets = routes.targets;
+    const uint8_t* delays = routes.delays;
+    if (delays == nullptr) return;
+    for (size_t s = 0; s < count; ++s) {
+        const uint32_t i = spikes[s];
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            if (delays[k] == 1) continue;
+            schedule(targets[k], k, delayed_due(t, delays[k], i, targets[k], sweep_order));
+        }
+    }
+}
+
+// Add the slot of step t of a delay ring (slots rows of n inputs) to
+// potential and clear it
+inline void apply_delay_slot(double* potential, double* ring, size_t slots, int t, size_t n) {
+    double* waiting = ring + ((size_t)t % slots) * n;
+    for (size_t i = 0; i < n; ++i) {
+        potential[i] += waiting[i];
+        waiting[i] = 0.0;
+    }
+}
+
+// Time-driven sweep: fire the chunks of bounds (see
+// SynapseStore::sweep_chunks()) in order, fire(begin, count, out) writing
+// the spikes of [begin, begin + count) ascending to out and returning how
+// many, and hand each chunk's spikes to deliver(spikes, fired) before the
+// next chunk fires. No neuron of a chunk feeds a later neuron of the same
+// chunk, so this is the same as updating neuron by neuron. Returns the
+// number of spikes written to spikes.
+template <typename Fire, typename Deliver>
+inline size_t sweep_in_chunks(const std::vector<uint32_t>& bounds, uint32_t* spikes,
+                              Fire fire, Deliver deliver) {
+    size_t num_spikes = 0;
+    for (size_t c = 0; c + 1 < bounds.size(); ++c) {
+        const size_t begin = bounds[c];
+        const size_t fired = fire(begin, bounds[c + 1] - begin, spikes + num_spikes);
+        deliver(spikes + num_spikes, fired);
+        num_spikes += fired;
+    }
+    return num_spikes;
+}
+
+#endif // SPIKE_DELIVERY_H
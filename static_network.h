@@ -0,0 +1,267 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include "network.h"
+#include "simd_kernels.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+// Layer sizes of a fully connected feed-forward network as compile-time
+// constants: layer l has size(l) neurons starting at index offset(l), and the
+// weights from layer l to layer l + 1 start at weight_offset(l).
+template <int... Sizes>
+struct LayerShape;
+
+template <int Last>
+struct LayerShape<Last> {
+    static constexpr int layers = 1;
+    static constexpr int neurons = Last;
+    static constexpr int synapses = 0;
+
+    static constexpr int size(int) { return Last; }
+    static constexpr int offset(int) { return 0; }
+    static constexpr int weight_offset(int) { return 0; }
+};
+
+template <int First, int Next, int... Rest>
+struct LayerShape<First, Next, Rest...> {
+    typedef LayerShape<Next, Rest...> Tail;
+    static constexpr int layers = 1 + Tail::layers;
+    static constexpr int neurons = First + Tail::neurons;
+    static constexpr int synapses = First * Next + Tail::synapses;
+
+    static constexpr int size(int l) { return l == 0 ? First : Tail::size(l - 1); }
+    static constexpr int offset(int l) { return l == 0 ? 0 : First + Tail::offset(l - 1); }
+    static constexpr int weight_offset(int l) {
+        return l == 0 ? 0 : First * Next + Tail::weight_offset(l - 1);
+    }
+};
+
+// Inference-only snapshot of a layered Network whose layer sizes are template
+// parameters, e.g. StaticNetwork<784, 400, 200, 10>. Every layer is fully
+// connected to the next one and nothing else, so the weights of layer l form
+// one dense size(l) x size(l + 1) matrix and the sweep is unrolled per layer
+// with every bound, offset and buffer size a compile-time constant; there is
+// no CSR lookup, chunk table or dense block search per spike. Runs the
+// time-driven double engine and reproduces Network::update() exactly: the
+// layers are the sweep chunks, each fired with the SIMD fire kernel and its
+// spikes delivered to the next layer, one matrix row per spike with the SIMD
+// accumulate kernel, before that layer fires. The runtime-dispatched kernels
+// are kept because they beat what the compiler makes of a fixed-width loop
+// at the baseline instruction set.
+//
+// Neuron state and the spike buffer are std::arrays sized by the shape, held
+// in the object itself; only the weights live on the heap. Copies share the
+// weights and get their own neuron state, so one copy per thread can
+// simulate different inputs concurrently.
+//
+// matches() tells whether a Network has this topology; use
+// with_static_network() to pick the specialization for a loaded network.
+template <int... Sizes>
+class StaticNetwork {
+public:
+    typedef LayerShape<Sizes...> Shape;
+    static_assert(Shape::layers >= 2, "StaticNetwork needs an input and an output layer");
+
+    // Copy the weights and neuron parameters of network, which must match()
+    explicit StaticNetwork(const Network& network);
+
+    // True if network has exactly these layers, fully connected layer to
+    // layer, with no other synapses and no synaptic delays
+    static bool matches(const Network& network);
+
+    // Get number of neurons
+    static constexpr size_t size() { return Shape::neurons; }
+
+    // Get total number of connections
+    static constexpr size_t connection_count() { return Shape::synapses; }
+
+    // Instruction set for the fire kernel (defaults to the best available)
+    void set_simd_level(SimdLevel level);
+    SimdLevel get_simd_level() const { return simd_level; }
+
+    // Reset all neurons to their resting state
+    void reset();
+
+    // Apply external input current to neuron i
+    void apply_input(size_t i, double current) { potential[i] += current; }
+
+    // Advance the network by one time step
+    void update();
+
+    // Spike and potential accessors
+    bool spiked(size_t i) const { return has_spiked[i] != 0; }
+    int get_spike_count(size_t i) const { return spike_count[i]; }
+    double get_potential(size_t i) const { return potential[i]; }
+
+    // Neurons that spiked in the last step, in ascending index order
+    struct SpikeList {
+        const uint32_t* first;
+        const uint32_t* last;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        uint32_t operator[](size_t s) const { return first[s]; }
+    };
+    SpikeList get_step_spikes() const {
+        SpikeList spikes = {step_spikes.data(), step_spikes.data() + num_step_spikes};
+        return spikes;
+    }
+
+private:
+    static constexpr size_t Total = Shape::neurons;
+
+    template <int L>
+    void sweep_layer(size_t num_spikes, std::integral_constant<int, L>);
+    void sweep_layer(size_t num_spikes, std::integral_constant<int, Shape::layers>);
+
+    std::array<double, Total> potential;
+    std::array<double, Total> threshold;
+    std::array<double, Total> resting;
+    std::array<double, Total> decay;
+    std::array<unsigned char, Total> has_spiked;
+    std::array<int, Total> spike_count;
+    std::shared_ptr<const std::vector<double>> weights;  // Layer matrices, row-major, one after another
+    std::array<uint32_t, Total> step_spikes;
+    size_t num_step_spikes;  // Valid entries of step_spikes
+    SimdLevel simd_level;
+    FireKernel fire_kernel;
+    AccumulateKernel accumulate_kernel;
+};
+
+template <int... Sizes>
+bool StaticNetwork<Sizes...>::matches(const Network& network) {
+    const SynapseStore& synapses = network.get_synapses();
+    if (network.size() != (size_t)Shape::neurons || synapses.size() != (size_t)Shape::synapses ||
+        synapses.max_delay() != 1) {
+        return false;
+    }
+
+    // With the synapse count fixed, every row reaching exactly the next
+    // layer leaves no room for other synapses
+    const uint32_t* targets = synapses.targets_data();
+    for (int l = 0; l + 1 < Shape::layers; ++l) {
+        const uint32_t first = (uint32_t)Shape::offset(l + 1);
+        const uint32_t width = (uint32_t)Shape::size(l + 1);
+        for (int i = Shape::offset(l); i < Shape::offset(l + 1); ++i) {
+            const uint32_t begin = synapses.row_begin(i);
+            const uint32_t end = synapses.row_end(i);
+            if (end - begin != width || targets[begin] != first ||
+                targets[end - 1] != first + width - 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <int... Sizes>
+StaticNetwork<Sizes...>::StaticNetwork(const Network& network) {
+    const NeuronState& state = network.get_state();
+    const SynapseStore& synapses = network.get_synapses();
+
+    std::copy(state.threshold.begin(), state.threshold.begin() + Total, threshold.begin());
+    std::copy(state.resting_potential.begin(), state.resting_potential.begin() + Total,
+              resting.begin());
+    std::copy(state.decay_factor.begin(), state.decay_factor.begin() + Total, decay.begin());
+    potential = resting;
+    has_spiked.fill(0);
+    spike_count.fill(0);
+    num_step_spikes = 0;
+
+    // Rows of a layer are adjacent and sorted by target, so the CSR weights
+    // of the non-output layers already are the layer matrices
+    weights = std::make_shared<const std::vector<double>>(synapses.weights_data(),
+                                                         synapses.weights_data() + Shape::synapses);
+
+    set_simd_level(network.get_simd_level());
+}
+
+template <int... Sizes>
+void StaticNetwork<Sizes...>::set_simd_level(SimdLevel level) {
+    if ((int)level > (int)detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    simd_level = level;
+    fire_kernel = select_fire_kernel(level);
+    accumulate_kernel = select_accumulate_kernel(level);
+}
+
+template <int... Sizes>
+void StaticNetwork<Sizes...>::reset() {
+    potential = resting;
+    has_spiked.fill(0);
+    spike_count.fill(0);
+    num_step_spikes = 0;
+}
+
+template <int... Sizes>
+void StaticNetwork<Sizes...>::update() {
+    sweep_layer(0, std::integral_constant<int, 0>());
+}
+
+template <int... Sizes>
+template <int L>
+void StaticNetwork<Sizes...>::sweep_layer(size_t num_spikes, std::integral_constant<int, L>) {
+    constexpr int begin = Shape::offset(L);
+    constexpr int count = Shape::size(L);
+    uint32_t* spikes = step_spikes.data() + num_spikes;
+    const size_t fired = fire_kernel(potential.data() + begin, threshold.data() + begin,
+                                     resting.data() + begin, decay.data() + begin,
+                                     has_spiked.data() + begin, count, (uint32_t)begin, spikes);
+    for (size_t s = 0; s < fired; ++s) {
+        spike_count[spikes[s]]++;
+    }
+
+    // Deliver to the next layer, which has not fired yet in this step
+    if (L + 1 < Shape::layers) {
+        constexpr int width = Shape::size(L + 1);
+        double* next = potential.data() + Shape::offset(L + 1);
+        const double* matrix = weights->data() + Shape::weight_offset(L);
+        for (size_t s = 0; s < fired; ++s) {
+            accumulate_kernel(next, matrix + (size_t)(spikes[s] - begin) * width, width);
+        }
+    }
+    sweep_layer(num_spikes + fired, std::integral_constant<int, L + 1>());
+}
+
+template <int... Sizes>
+void StaticNetwork<Sizes...>::sweep_layer(size_t num_spikes,
+                                          std::integral_constant<int, Shape::layers>) {
+    num_step_spikes = num_spikes;
+}
+
+// The fixed MNIST architectures of train_mnist and test_mnist
+typedef StaticNetwork<784, 300, 10> SimpleStaticNetwork;
+typedef StaticNetwork<784, 400, 200, 10> MediumStaticNetwork;
+typedef StaticNetwork<784, 512, 256, 128, 10> ComplexStaticNetwork;
+
+// Snapshot network into the StaticNetwork specialization it matches and call
+// visitor(static_network). Returns false, without calling visitor, if it
+// matches none of the architectures above.
+template <typename Visitor>
+bool with_static_network(const Network& network, Visitor& visitor) {
+    if (MediumStaticNetwork::matches(network)) {
+        MediumStaticNetwork snapshot(network);
+        visitor(snapshot);
+        return true;
+    }
+    if (SimpleStaticNetwork::matches(network)) {
+        SimpleStaticNetwork snapshot(network);
+        visitor(snapshot);
+        return true;
+    }
+    if (ComplexStaticNetwork::matches(network)) {
+        ComplexStaticNetwork snapshot(network);
+        visitor(snapshot);
+        return true;
+    }
+    return false;
+}
+
+#endif // STATIC_NETWORK_H
@@ -0,0 +1,36 @@
+#include "stdp_kernel.h"
+
+StdpKernel::StdpKernel(double learning_rate, double tau_plus, double tau_minus, int window)
+    : exp_kernel(select_exp_kernel(detect_simd_level())) {
+    configure(learning_rate, tau_plus, tau_minus, window);
+}
+
+void StdpKernel::configure(double learning_rate, double tau_plus, double tau_minus, int window) {
+    rate = learning_rate;
+    tau_p = tau_plus;
+    tau_m = tau_minus;
+    span = window < 0 ? 0 : window;
+
+    const size_t entries = (size_t)span + 1;
+    plus_trace.resize(entries);
+    minus_trace.resize(entries);
+    plus_change.resize(entries);
+    minus_change.resize(entries);
+    for (size_t dt = 0; dt < entries; ++dt) {
+        plus_trace[dt] = -(double)dt / tau_p;
+        minus_trace[dt] = -(double)dt / tau_m;
+    }
+    exp_kernel(plus_trace.data(), plus_trace.data(), entries);
+    exp_kernel(minus_trace.data(), minus_trace.data(), entries);
+    for (size_t dt = 0; dt < entries; ++dt) {
+        plus_change[dt] = rate * plus_trace[dt];
+        minus_change[dt] = rate * minus_trace[dt];
+    }
+}
+
+double StdpKernel::exp_beyond(int dt, double tau) const {
+    const double x = -(double)dt / tau;
+    double result;
+    exp_kernel(&x, &result, 1);
+    return result;
+}
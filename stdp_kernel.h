@@ -0,0 +1,98 @@
+#ifndef STDP_KERNEL_H
+#define STDP_KERNEL_H
+
+#include "simd_kernels.h"
+#include <vector>
+#include <cstddef>
+
+// Number of spike time differences tabulated by default
+const int DEFAULT_STDP_WINDOW = 256;
+
+// Time constants (in steps) of the pre- and post-synaptic STDP traces used
+// by Network::update_with_learning()
+const double STDP_TAU_PLUS = 20.0;
+const double STDP_TAU_MINUS = 20.0;
+
+// Pair-based STDP rule with its factors precomputed. Spike times are whole
+// steps, so every weight change is learning_rate * exp(-dt / tau) for a small
+// integer dt; the kernel tabulates exp(-dt / tau_plus) and
+// exp(-dt / tau_minus) and both scaled changes for dt in [0, window], and the
+// learning paths look them up instead of calling exp(). Differences beyond
+// the window (rare, and tiny by then) go through the vectorized exponential
+// of simd_kernels.h, which also fills the tables, so no learning path calls
+// libm. Tables are bit-identical on every CPU.
+//
+// Lookups are read-only and may run on any number of threads at once.
+class StdpKernel {
+public:
+    StdpKernel(double learning_rate = 0.01, double tau_plus = STDP_TAU_PLUS,
+               double tau_minus = STDP_TAU_MINUS, int window = DEFAULT_STDP_WINDOW);
+
+    // Retabulate for new parameters. Reuses the tables when the window does
+    // not grow, so a running simulation can switch learning rates without
+    // allocating.
+    void configure(double learning_rate, double tau_plus, double tau_minus,
+                   int window = DEFAULT_STDP_WINDOW);
+
+    // Whether the tables were computed for these parameters
+    bool matches(double learning_rate, double tau_plus, double tau_minus) const {
+        return learning_rate == rate && tau_plus == tau_p && tau_minus == tau_m;
+    }
+
+    double learning_rate() const { return rate; }
+    double tau_plus() const { return tau_p; }
+    double tau_minus() const { return tau_m; }
+    int window() const { return span; }
+
+    // Pre-synaptic trace dt >= 0 steps after its spike: exp(-dt / tau_plus)
+    double trace_plus(int dt) const {
+        return dt <= span ? plus_trace[dt] : exp_beyond(dt, tau_p);
+    }
+
+    // Post-synaptic trace dt >= 0 steps after its spike: exp(-dt / tau_minus)
+    double trace_minus(int dt) const {
+        return dt <= span ? minus_trace[dt] : exp_beyond(dt, tau_m);
+    }
+
+    // Weight increase when the pre-synaptic spike came dt > 0 steps before
+    // the post-synaptic one (LTP): learning_rate * trace_plus(dt)
+    double potentiation(int dt) const {
+        return dt <= span ? plus_change[dt] : rate * exp_beyond(dt, tau_p);
+    }
+
+    // Weight decrease when the post-synaptic spike came dt > 0 steps before
+    // the pre-synaptic one (LTD): learning_rate * trace_minus(dt)
+    double depression(int dt) const {
+        return dt <= span ? minus_change[dt] : rate * exp_beyond(dt, tau_m);
+    }
+
+    // Apply the rule to one synapse, dt = post spike time - pre spike time:
+    // potentiate if dt > 0, depress if dt < 0, clamp to [0, 1]
+    void apply(double& weight, int dt) const {
+        if (dt > 0) {
+            weight += potentiation(dt);
+            if (weight > 1.0) weight = 1.0;
+        } else if (dt < 0) {
+            weight -= depression(-dt);
+            if (weight < 0.0) weight = 0.0;
+        }
+    }
+
+private:
+    // exp(-dt / tau) outside the tables
+    double exp_beyond(int dt, double tau) const;
+
+    double rate;
+    double tau_p;
+    double tau_m;
+    int span;
+    ExpKernel exp_kernel;
+
+    // Indexed by dt in [0, span]
+    std::vector<double> plus_trace;
+    std::vector<double> minus_trace;
+    std::vector<double> plus_change;
+    std::vector<double> minus_change;
+};
+
+#endif // STDP_KERNEL_H
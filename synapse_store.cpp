@@ -0,0 +1,187 @@
+#include "synapse_store.h"
+#include <algorithm>
+
+void SynapseStore::resize(size_t num_neurons) {
+    row_offsets.assign(num_neurons + 1, 0);
+    targets.clear();
+    weights.clear();
+    delays.clear();
+    pending.clear();
+    pending_sorted = true;
+    longest_delay = 1;
+    ++topology_version;
+}
+
+void SynapseStore::connect(uint32_t from, uint32_t to, double weight, uint8_t delay) {
+    append_edit(from, to, weight, delay, false);
+}
+
+void SynapseStore::disconnect(uint32_t from, uint32_t to) {
+    append_edit(from, to, 0.0, 1, true);
+}
+
+void SynapseStore::compact() const {
+    if (pending.empty()) return;
+
+    // Order edits by (from, to); stable so the latest edit to an edge wins.
+    // Edits that were appended in order (bulk layers) need no sort.
+    if (!pending_sorted) {
+        std::stable_sort(pending.begin(), pending.end(),
+            [](const Edit& a, const Edit& b) {
+                return a.from < b.from || (a.from == b.from && a.to < b.to);
+            });
+    }
+
+    const size_t rows = num_neurons();
+    std::vector<uint32_t> new_offsets(rows + 1, 0);
+    std::vector<uint32_t> new_targets;
+    std::vector<double> new_weights;
+    std::vector<uint8_t> new_delays;
+    new_targets.reserve(targets.size() + pending.size());
+    new_weights.reserve(targets.size() + pending.size());
+    new_delays.reserve(targets.size() + pending.size());
+
+    // Merge each sorted CSR row with the sorted edits for that row
+    size_t p = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        new_offsets[row] = (uint32_t)new_targets.size();
+        size_t k = row_offsets[row];
+        const size_t end = row_offsets[row + 1];
+
+        while (k < end || (p < pending.size() && pending[p].from == row)) {
+            bool take_edit = p < pending.size() && pending[p].from == row &&
+                             (k == end || pending[p].to <= targets[k]);
+            if (!take_edit) {
+                new_targets.push_back(targets[k]);
+                new_weights.push_back(weights[k]);
+                new_delays.push_back(delays[k]);
+                ++k;
+                continue;
+            }
+
+            // Skip to the last edit of this edge
+            size_t last = p;
+            while (last + 1 < pending.size() && pending[last + 1].from == row &&
+                   pending[last + 1].to == pending[p].to) {
+                ++last;
+            }
+            if (k < end && targets[k] == pending[p].to) {
+                ++k;  // Existing synapse is replaced (or removed) by the edit
+            }
+            if (!pending[last].remove) {
+                new_targets.push_back(pending[last].to);
+                new_weights.push_back(pending[last].weight);
+                new_delays.push_back(pending[last].delay);
+            }
+            p = last + 1;
+        }
+    }
+    new_offsets[rows] = (uint32_t)new_targets.size();
+
+    row_offsets.swap(new_offsets);
+    targets.swap(new_targets);
+    weights.swap(new_weights);
+    delays.swap(new_delays);
+    std::vector<Edit>().swap(pending);  // Bulk builds leave a large log behind
+    pending_sorted = true;
+    longest_delay = 1;
+    for (uint8_t delay : delays) {
+        if (delay > longest_delay) longest_delay = delay;
+    }
+    ++topology_version;
+}
+
+void SynapseStore::build_incoming() const {
+    // Rows are visited in order, so each neuron's incoming synapses come out
+    // by ascending source
+    const size_t rows = num_neurons();
+    const size_t total = targets.size();
+    in_offsets.assign(rows + 1, 0);
+    for (size_t k = 0; k < total; ++k) {
+        in_offsets[targets[k] + 1]++;
+    }
+    for (size_t j = 0; j < rows; ++j) {
+        in_offsets[j + 1] += in_offsets[j];
+    }
+    in_slots.resize(total);
+    in_sources.resize(total);
+    std::vector<uint32_t> next(in_offsets.begin(), in_offsets.end() - 1);
+    for (size_t i = 0; i < rows; ++i) {
+        for (uint32_t k = row_offsets[i]; k < row_offsets[i + 1]; ++k) {
+            const uint32_t c = next[targets[k]]++;
+            in_slots[c] = k;
+            in_sources[c] = (uint32_t)i;
+        }
+    }
+    incoming_version = topology_version;
+}
+
+long SynapseStore::find(uint32_t from, uint32_t to) const {
+    compact();
+    if (from >= num_neurons()) return -1;
+    const uint32_t* begin = targets.data() + row_offsets[from];
+    const uint32_t* end = targets.data() + row_offsets[from + 1];
+    const uint32_t* it = std::lower_bound(begin, end, to);
+    if (it == end || *it != to) return -1;
+    return (long)(it - targets.data());
+}
+
+void SynapseStore::sweep_chunks(std::vector<uint32_t>& bounds) const {
+    compact();
+    const size_t n = num_neurons();
+
+    // A chunk ends just before the first neuron that is the target of an
+    // earlier neuron in it
+    bounds.clear();
+    bounds.push_back(0);
+    const uint32_t* row_targets = targets.data();
+    size_t limit = n;  // Lowest forward target of the current chunk
+    for (size_t i = 0; i < n; ++i) {
+        if (i == limit) {
+            bounds.push_back((uint32_t)i);
+            limit = n;
+        }
+        const uint32_t* row_end = row_targets + row_offsets[i + 1];
+        const uint32_t* next = std::upper_bound(row_targets + row_offsets[i], row_end,
+                                                (uint32_t)i);
+        if (next != row_end && *next < limit) {
+            limit = *next;
+        }
+    }
+    bounds.push_back((uint32_t)n);
+}
+
+void SynapseStore::dense_blocks(std::vector<DenseBlock>& blocks,
+                                std::vector<int32_t>& block_of_row) const {
+    compact();
+    const size_t n = num_neurons();
+    blocks.clear();
+    block_of_row.assign(n, -1);
+
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t begin = row_offsets[i];
+        const uint32_t end = row_offsets[i + 1];
+        if (end == begin || targets[end - 1] - targets[begin] != end - begin - 1) {
+            continue;  // Empty, or targets are not consecutive
+        }
+        if (longest_delay > 1 &&
+            std::find_if(delays.begin() + begin, delays.begin() + end,
+                         [](uint8_t delay) { return delay != 1; }) != delays.begin() + end) {
+            continue;  // Delayed synapses go through the delay ring
+        }
+
+        // Extend the previous block if this row continues it
+        if (!blocks.empty()) {
+            DenseBlock& last = blocks.back();
+            if (last.source_end == i && last.target_begin == targets[begin] &&
+                last.target_end == targets[end - 1] + 1) {
+                last.source_end = (uint32_t)i + 1;
+                block_of_row[i] = (int32_t)blocks.size() - 1;
+                continue;
+            }
+        }
+        DenseBlock block = {(uint32_t)i, (uint32_t)i + 1, targets[begin], targets[end - 1] + 1, begin};
+        blocks.push_back(block);
+        block_of_row[i] = (int32_t)blocks.size() - 1;
+    }
+}
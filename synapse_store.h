@@ -0,0 +1,246 @@
+#ifndef SYNAPSE_STORE_H
+#define SYNAPSE_STORE_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// A run of source neurons [source_begin, source_end) that all connect to
+// exactly the consecutive targets [target_begin, target_end), as a fully
+// connected layer does. The CSR rows of such a run are adjacent and equally
+// long, so the weights form a dense row-major matrix starting at first_slot
+// with one row of (target_end - target_begin) weights per source.
+struct DenseBlock {
+    uint32_t source_begin;
+    uint32_t source_end;
+    uint32_t target_begin;
+    uint32_t target_end;
+    uint32_t first_slot;
+
+    size_t width() const { return target_end - target_begin; }
+};
+
+// Longest synaptic transmission delay, in time steps (delays are 1..this)
+const int MAX_SYNAPSE_DELAY = 255;
+
+// Compressed sparse row (CSR) storage for all synapses of a network.
+// Row i holds the outgoing synapses of neuron i in [row_begin(i), row_end(i)),
+// sorted by target index. Targets are 32-bit neuron indices and weights live
+// in a parallel array, so spike delivery is a streaming read over two arrays.
+// Each synapse also has an integer delay in a third parallel array; it is
+// only read when some synapse has a delay above 1.
+//
+// connect()/disconnect() only record an edit; edits are folded into the CSR
+// arrays by compact(), which every accessor calls first. This keeps network
+// construction linear instead of shifting the arrays on every insert.
+class SynapseStore {
+public:
+    // Set the number of rows (neurons); drops all synapses
+    void resize(size_t num_neurons);
+
+    // Add a synapse, or update its weight and delay if it already exists.
+    // delay must be in [1, MAX_SYNAPSE_DELAY].
+    void connect(uint32_t from, uint32_t to, double weight, uint8_t delay = 1);
+
+    // Remove the synapse from -> to if it exists
+    void disconnect(uint32_t from, uint32_t to);
+
+    // Bulk connect(): every from in [from_begin, from_end) to every to in
+    // [to_begin, to_end), or every (from, to) pair of pairs, with weight
+    // init(from, to) and delay 1. Ranges are clipped to num_neurons(). init is
+    // called once per pair in order, also for the self-connections and (in
+    // pairs) out-of-range neurons that are skipped, so a seeded generator
+    // draws as in a connect() loop. A dense block whose source rows have no
+    // synapses yet (and no edits pending), as when a network is built layer
+    // by layer, is written straight into the CSR arrays. Otherwise the
+    // connections go to the edit log in one reserved run; if they arrive in
+    // ascending (from, to) order the log stays sorted and compact() folds
+    // them in without sorting, else compact() sorts once and the last edit to
+    // a repeated connection wins as with connect().
+    template <typename Init>
+    void connect_dense(uint32_t from_begin, uint32_t from_end,
+                       uint32_t to_begin, uint32_t to_end, Init init) {
+        from_end = std::min(from_end, (uint32_t)num_neurons());
+        to_end = std::min(to_end, (uint32_t)num_neurons());
+        if (from_end <= from_begin || to_end <= to_begin) return;
+        const size_t added = (size_t)(from_end - from_begin) * (to_end - to_begin);
+        if (pending.empty() && row_offsets[from_begin] == targets.size()) {
+            targets.reserve(targets.size() + added);
+            weights.reserve(weights.size() + added);
+            delays.reserve(delays.size() + added);
+            for (uint32_t from = from_begin; from < from_end; ++from) {
+                for (uint32_t to = to_begin; to < to_end; ++to) {
+                    if (from == to) {
+                        (void)init(from, to);
+                        continue;
+                    }
+                    targets.push_back(to);
+                    weights.push_back(init(from, to));
+                    delays.push_back(1);
+                }
+                row_offsets[from + 1] = (uint32_t)targets.size();
+            }
+            for (size_t row = (size_t)from_end + 1; row < row_offsets.size(); ++row) {
+                row_offsets[row] = (uint32_t)targets.size();
+            }
+            ++topology_version;
+            return;
+        }
+        pending.reserve(pending.size() + added);
+        for (uint32_t from = from_begin; from < from_end; ++from) {
+            for (uint32_t to = to_begin; to < to_end; ++to) {
+                const double weight = init(from, to);
+                if (from != to) append_edit(from, to, weight, 1, false);
+            }
+        }
+    }
+    template <typename Init>
+    void connect_sparse(const std::vector<std::pair<uint32_t, uint32_t>>& pairs, Init init) {
+        const uint32_t rows = (uint32_t)num_neurons();
+        pending.reserve(pending.size() + pairs.size());
+        for (const std::pair<uint32_t, uint32_t>& pair : pairs) {
+            const double weight = init(pair.first, pair.second);
+            if (pair.first != pair.second && pair.first < rows && pair.second < rows) {
+                append_edit(pair.first, pair.second, weight, 1, false);
+            }
+        }
+    }
+
+    // Fold pending edits into the CSR arrays (no-op if there are none)
+    void compact() const;
+
+    // Number of rows (neurons)
+    size_t num_neurons() const { return row_offsets.size() - 1; }
+
+    // Total number of synapses
+    size_t size() const { compact(); return targets.size(); }
+
+    // Row bounds for the outgoing synapses of neuron i
+    uint32_t row_begin(size_t i) const { compact(); return row_offsets[i]; }
+    uint32_t row_end(size_t i) const { compact(); return row_offsets[i + 1]; }
+    size_t out_degree(size_t i) const { return row_end(i) - row_begin(i); }
+
+    // Raw CSR arrays (valid until the next edit)
+    const uint32_t* offsets_data() const { compact(); return row_offsets.data(); }
+    const uint32_t* targets_data() const { compact(); return targets.data(); }
+    const double* weights_data() const { compact(); return weights.data(); }
+    double* weights_data() { compact(); return weights.data(); }
+    const uint8_t* delays_data() const { compact(); return delays.data(); }
+
+    // Reverse (CSC) index: the synapses into neuron j are the forward slots
+    // incoming_slots_data()[in_begin(j) .. in_end(j)), in ascending source
+    // order, and incoming_sources_data() holds the source of each. A slot
+    // indexes the CSR arrays above, so weights_data()[slot] is the weight.
+    // Built on first use and rebuilt on the first use after compact() folds
+    // in edits, so a store that is never asked pays nothing. Build it from
+    // one thread before reading it from several.
+    uint32_t in_begin(size_t j) const { index_incoming(); return in_offsets[j]; }
+    uint32_t in_end(size_t j) const { index_incoming(); return in_offsets[j + 1]; }
+    size_t in_degree(size_t j) const { return in_end(j) - in_begin(j); }
+    const uint32_t* incoming_offsets_data() const { index_incoming(); return in_offsets.data(); }
+    const uint32_t* incoming_slots_data() const { index_incoming(); return in_slots.data(); }
+    const uint32_t* incoming_sources_data() const { index_incoming(); return in_sources.data(); }
+
+    // Largest delay of any synapse (1 if there are none)
+    int max_delay() const { compact(); return longest_delay; }
+
+    // Slot index of the synapse from -> to, or -1 if it does not exist
+    long find(uint32_t from, uint32_t to) const;
+
+    // Split the neurons into consecutive chunks that contain no synapse from
+    // a neuron to a later neuron of the same chunk. bounds receives the chunk
+    // boundaries (0, ..., num_neurons()); for layered networks the chunks are
+    // the layers.
+    void sweep_chunks(std::vector<uint32_t>& bounds) const;
+
+    // Find the dense blocks of the network: every row whose targets are
+    // consecutive neurons and whose delays are all 1 belongs to exactly one
+    // block, merged with its neighbours when they share the same targets.
+    // block_of_row receives the block index of every row (-1 for rows that
+    // are not dense).
+    void dense_blocks(std::vector<DenseBlock>& blocks, std::vector<int32_t>& block_of_row) const;
+
+    // Changes whenever connect()/disconnect() edits are folded in, so callers
+    // can cache data derived from the topology
+    uint64_t version() const { compact(); return topology_version; }
+
+private:
+    struct Edit {
+        uint32_t from;
+        uint32_t to;
+        double weight;
+        uint8_t delay;
+        bool remove;
+    };
+
+    // Add an edit to the log, noting whether the log is still in (from, to) order
+    void append_edit(uint32_t from, uint32_t to, double weight, uint8_t delay, bool remove) {
+        if (!pending.empty() && (from < pending.back().from ||
+                                 (from == pending.back().from && to < pending.back().to))) {
+            pending_sorted = false;
+        }
+        Edit edit = {from, to, weight, delay, remove};
+        pending.push_back(edit);
+    }
+
+    // Bring the reverse index up to date with the CSR arrays
+    void index_incoming() const {
+        compact();
+        if (incoming_version != topology_version) build_incoming();
+    }
+
+    // Counting sort of the synapses by target into in_offsets/in_slots/in_sources
+    void build_incoming() const;
+
+    // CSR arrays and the edit log are folded lazily from const accessors
+    mutable std::vector<uint32_t> row_offsets = std::vector<uint32_t>(1, 0);
+    mutable std::vector<uint32_t> targets;
+    mutable std::vector<double> weights;
+    mutable std::vector<uint8_t> delays;
+    mutable std::vector<Edit> pending;
+    mutable bool pending_sorted = true;  // pending is in (from, to) order
+    mutable uint64_t topology_version = 0;
+    mutable int longest_delay = 1;
+
+    // Reverse index, valid while incoming_version == topology_version
+    mutable std::vector<uint32_t> in_offsets;
+    mutable std::vector<uint32_t> in_slots;
+    mutable std::vector<uint32_t> in_sources;
+    mutable uint64_t incoming_version = UINT64_MAX;
+};
+
+// Read-only synapse arrays of an inference snapshot (CompiledNetwork,
+// QuantizedNetwork): the CSR rows with weights converted to Weight, the sweep
+// chunks and the dense blocks. Snapshots hold them through a shared_ptr, so a
+// copy of a snapshot shares the synapses and only duplicates neuron state.
+template <typename Weight>
+struct SnapshotSynapses {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<Weight> weights;
+    std::vector<uint32_t> sweep_chunks;
+    std::vector<DenseBlock> dense_blocks;
+    std::vector<int32_t> dense_block_of_row;
+
+    // Copy the topology of store, converting every weight with convert(w)
+    template <typename Convert>
+    SnapshotSynapses(const SynapseStore& store, Convert convert) {
+        const size_t n = store.num_neurons();
+        const uint32_t* source_offsets = store.offsets_data();
+        const size_t total = source_offsets[n];
+        const double* source_weights = store.weights_data();
+        offsets.assign(source_offsets, source_offsets + n + 1);
+        targets.assign(store.targets_data(), store.targets_data() + total);
+        weights.resize(total);
+        for (size_t k = 0; k < total; ++k) {
+            weights[k] = convert(source_weights[k]);
+        }
+        store.sweep_chunks(sweep_chunks);
+        store.dense_blocks(dense_blocks, dense_block_of_row);
+    }
+};
+
+#endif // SYNAPSE_STORE_H
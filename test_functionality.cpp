@@ -1,13 +1,75 @@
 #include "network.h"
+#include "model.h"
+#include "learning_state.h"
+#include "static_network.h"
+#include "stdp_kernel.h"
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <vector>
+#include <cstdint>
 
 // Test helper function
 bool approximately_equal(double a, double b, double epsilon = 0.001) {
     return std::abs(a - b) < epsilon;
 }
 
+// Spikes of every step of a run, in ascending index order per step
+typedef std::vector<std::vector<uint32_t>> SpikeTrace;
+
+// Small linear congruential generator, so the random networks below are the
+// same on every platform
+struct TestRandom {
+    uint32_t seed;
+    explicit TestRandom(uint32_t s) : seed(s) {}
+    uint32_t next() { seed = seed * 1664525u + 1013904223u; return seed >> 8; }
+    double uniform(double low, double high) { return low + (high - low) * (next() / 16777216.0); }
+};
+
+// Random recurrent network: each ordered pair connected with probability
+// 1/4, weights in [-0.5, 0.7) and delays in [1, max_delay]
+void build_recurrent_network(Network& network, uint32_t seed, int max_delay) {
+    TestRandom random(seed);
+    for (size_t i = 0; i < network.size(); ++i) {
+        for (size_t j = 0; j < network.size(); ++j) {
+            if (i == j || random.next() % 4 != 0) continue;
+            const double weight = random.uniform(-0.5, 0.7);
+            network.connect(i, j, weight, 1 + (int)(random.next() % max_delay));
+        }
+    }
+}
+
+// External input for neuron i at step t (the first few neurons are driven)
+double test_input(int t, size_t i) {
+    return 0.25 + 0.15 * ((t * 7 + i * 3) % 5);
+}
+
+// Drive the first 8 neurons of network for steps steps and record its spikes
+SpikeTrace run_driven(Network& network, int steps) {
+    SpikeTrace trace;
+    for (int t = 0; t < steps; ++t) {
+        for (size_t i = 0; i < 8; ++i) {
+            network.get_neuron(i)->apply_input(test_input(t, i));
+        }
+        network.update();
+        trace.push_back(network.get_step_spikes());
+    }
+    return trace;
+}
+
+// Total number of spikes in trace
+size_t count_spikes(const SpikeTrace& trace) {
+    size_t total = 0;
+    for (const std::vector<uint32_t>& step : trace) total += step.size();
+    return total;
+}
+
+// Current synaptic weights of network, in CSR order
+std::vector<double> weights_of(const Network& network) {
+    const SynapseStore& synapses = network.get_synapses();
+    return std::vector<double>(synapses.weights_data(), synapses.weights_data() + synapses.size());
+}
+
 void test_neuron_basic() {
     std::cout << "Test 1: Basic Neuron Functionality\n";
     
@@ -162,6 +224,289 @@ void test_sustained_input() {
     std::cout << "  ✓ Passed\n\n";
 }
 
+void test_engine_equivalence() {
+    std::cout << "Test 6: Engine Equivalence on a Recurrent Network\n";
+    
+    // Negative weights and recurrent loops, first with delay 1 only, then
+    // with delays up to 4
+    for (int max_delay = 1; max_delay <= 4; max_delay += 3) {
+        Network time_driven(40), event_driven(40), serial(40), pooled(40);
+        build_recurrent_network(time_driven, 7, max_delay);
+        build_recurrent_network(event_driven, 7, max_delay);
+        build_recurrent_network(serial, 7, max_delay);
+        build_recurrent_network(pooled, 7, max_delay);
+        event_driven.set_simulation_mode(SimulationMode::EventDriven);
+        serial.set_simulation_mode(SimulationMode::TwoPhase);
+        pooled.set_simulation_mode(SimulationMode::TwoPhase);
+        pooled.set_num_threads(3);
+        
+        // Time- and event-driven deliver in the same order
+        SpikeTrace reference = run_driven(time_driven, 200);
+        assert(count_spikes(reference) > 500);
+        assert(run_driven(event_driven, 200) == reference);
+        
+        // Two-phase delivers a step later, serial or split across workers
+        SpikeTrace two_phase = run_driven(serial, 200);
+        assert(count_spikes(two_phase) > 500);
+        assert(run_driven(pooled, 200) == two_phase);
+    }
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_reset_and_snapshot() {
+    std::cout << "Test 7: Reset and Snapshot Replay\n";
+    
+    const SimulationMode modes[] = {SimulationMode::TimeDriven, SimulationMode::EventDriven,
+                                    SimulationMode::TwoPhase};
+    SpikeTrace time_driven_replay;
+    for (SimulationMode mode : modes) {
+        // reset() returns to rest and drops input still in the delay ring
+        Network network(40);
+        build_recurrent_network(network, 11, 4);
+        network.set_simulation_mode(mode);
+        SpikeTrace first = run_driven(network, 150);
+        network.reset();
+        assert(run_driven(network, 150) == first);
+        
+        // Potentials saved before the first step, some above threshold
+        Network snapshot(40);
+        build_recurrent_network(snapshot, 11, 4);
+        snapshot.set_simulation_mode(mode);
+        for (size_t i = 0; i < 40; ++i) {
+            snapshot.get_neuron(i)->apply_input(i % 3 == 0 ? 1.2 : 0.1 * (i % 7));
+        }
+        snapshot.save_snapshot();
+        SpikeTrace replay = run_driven(snapshot, 150);
+        assert(count_spikes(replay) > 300);
+        snapshot.reset_to_snapshot();
+        assert(run_driven(snapshot, 150) == replay);
+        snapshot.reset_to_snapshot();
+        assert(run_driven(snapshot, 150) == replay);
+        
+        // Time- and event-driven also agree from the snapshot
+        if (mode == SimulationMode::TimeDriven) time_driven_replay = replay;
+        if (mode == SimulationMode::EventDriven) assert(replay == time_driven_replay);
+    }
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_stdp_reference() {
+    std::cout << "Test 8: Trace STDP Against a Brute-Force Reference\n";
+    
+    // The tabulated kernel is the exponential rule
+    const double learning_rate = 0.02;
+    StdpKernel kernel(learning_rate);
+    for (int dt = 1; dt <= 400; ++dt) {
+        assert(approximately_equal(kernel.potentiation(dt), learning_rate * std::exp(-dt / STDP_TAU_PLUS), 1e-15));
+        assert(approximately_equal(kernel.depression(dt), learning_rate * std::exp(-dt / STDP_TAU_MINUS), 1e-15));
+    }
+    
+    Network network(40);
+    build_recurrent_network(network, 3, 1);
+    const SynapseStore& synapses = network.get_synapses();
+    std::vector<double> weights = weights_of(network);
+    std::vector<int> last_spike(40, -1);
+    std::vector<unsigned char> spiked(40);
+    for (int t = 0; t < 300; ++t) {
+        for (size_t i = 0; i < 8; ++i) {
+            network.get_neuron(i)->apply_input(test_input(t, i));
+        }
+        network.update_with_learning(t, learning_rate);
+        
+        // Every synapse visited: depression when the source spiked after the
+        // target, then potentiation when the target spiked after the source
+        std::fill(spiked.begin(), spiked.end(), 0);
+        for (uint32_t i : network.get_step_spikes()) spiked[i] = 1;
+        for (size_t from = 0; from < 40; ++from) {
+            for (uint32_t k = synapses.row_begin(from); k < synapses.row_end(from); ++k) {
+                const uint32_t to = synapses.targets_data()[k];
+                if (spiked[from] && last_spike[to] >= 0 && t > last_spike[to]) {
+                    weights[k] = std::max(0.0, weights[k] - kernel.depression(t - last_spike[to]));
+                }
+            }
+        }
+        for (size_t from = 0; from < 40; ++from) {
+            for (uint32_t k = synapses.row_begin(from); k < synapses.row_end(from); ++k) {
+                const uint32_t to = synapses.targets_data()[k];
+                if (spiked[to] && last_spike[from] >= 0 && t > last_spike[from]) {
+                    weights[k] = std::min(1.0, weights[k] + kernel.potentiation(t - last_spike[from]));
+                }
+            }
+        }
+        for (uint32_t i : network.get_step_spikes()) last_spike[i] = t;
+        
+        std::vector<double> learned = weights_of(network);
+        for (size_t k = 0; k < weights.size(); ++k) {
+            assert(learned[k] == weights[k]);
+        }
+    }
+    
+    // Learning actually moved the weights
+    Network untrained(40);
+    build_recurrent_network(untrained, 3, 1);
+    std::vector<double> initial = weights_of(untrained);
+    size_t moved = 0;
+    for (size_t k = 0; k < weights.size(); ++k) {
+        if (weights[k] != initial[k]) ++moved;
+    }
+    assert(moved > weights.size() / 4);
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_stdp_pooled() {
+    std::cout << "Test 9: Serial and Pooled STDP\n";
+    
+    Network serial(40), pooled(40);
+    build_recurrent_network(serial, 5, 1);
+    build_recurrent_network(pooled, 5, 1);
+    pooled.set_num_threads(3);
+    for (int t = 0; t < 300; ++t) {
+        for (size_t i = 0; i < 8; ++i) {
+            serial.get_neuron(i)->apply_input(test_input(t, i));
+            pooled.get_neuron(i)->apply_input(test_input(t, i));
+        }
+        serial.update_with_learning(t, 0.02);
+        pooled.update_with_learning(t, 0.02);
+        assert(serial.get_step_spikes() == pooled.get_step_spikes());
+        assert(weights_of(serial) == weights_of(pooled));
+    }
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_learning_state() {
+    std::cout << "Test 10: LearningState Matches Network Learning\n";
+    
+    Network shared(40), reference(40);
+    build_recurrent_network(shared, 9, 1);
+    build_recurrent_network(reference, 9, 1);
+    LearningState learner(shared);
+    size_t spikes = 0;
+    for (int t = 0; t < 300; ++t) {
+        for (size_t i = 0; i < 8; ++i) {
+            learner.apply_input(i, test_input(t, i));
+            reference.get_neuron(i)->apply_input(test_input(t, i));
+        }
+        learner.update_with_learning(t, 0.02);
+        reference.update_with_learning(t, 0.02);
+        assert(learner.get_step_spikes() == reference.get_step_spikes());
+        assert(weights_of(shared) == weights_of(reference));
+        spikes += learner.get_step_spikes().size();
+    }
+    assert(spikes > 500);
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_simulation_state() {
+    std::cout << "Test 11: SimulationState Matches Network\n";
+    
+    const SimulationMode modes[] = {SimulationMode::TimeDriven, SimulationMode::TwoPhase};
+    for (SimulationMode mode : modes) {
+        Network network(40);
+        build_recurrent_network(network, 13, 4);
+        network.set_simulation_mode(mode);
+        SimulationState simulation(network.make_model());
+        simulation.set_simulation_mode(mode);
+        SpikeTrace trace;
+        for (int t = 0; t < 200; ++t) {
+            for (size_t i = 0; i < 8; ++i) {
+                simulation.apply_input(i, test_input(t, i));
+            }
+            simulation.update();
+            trace.push_back(simulation.get_step_spikes());
+        }
+        assert(count_spikes(trace) > 500);
+        assert(run_driven(network, 200) == trace);
+        
+        // reset() drops the input still in the delay ring
+        simulation.reset();
+        for (int t = 0; t < 200; ++t) {
+            for (size_t i = 0; i < 8; ++i) {
+                simulation.apply_input(i, test_input(t, i));
+            }
+            simulation.update();
+            assert(simulation.get_step_spikes() == trace[t]);
+        }
+    }
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_static_network() {
+    std::cout << "Test 12: StaticNetwork Matches Network\n";
+    
+    // Layers of 20, 15 and 5 neurons, fully connected
+    Network network(40);
+    TestRandom random(17);
+    network.connect_dense(0, 20, 20, 35, [&random](uint32_t, uint32_t) { return random.uniform(-0.2, 0.4); });
+    network.connect_dense(20, 35, 35, 40, [&random](uint32_t, uint32_t) { return random.uniform(-0.2, 0.6); });
+    assert((StaticNetwork<20, 15, 5>::matches(network)));
+    StaticNetwork<20, 15, 5> compiled(network);
+    
+    size_t output_spikes = 0;
+    for (int t = 0; t < 200; ++t) {
+        for (size_t i = 0; i < 20; ++i) {
+            network.get_neuron(i)->apply_input(test_input(t, i));
+            compiled.apply_input(i, test_input(t, i));
+        }
+        network.update();
+        compiled.update();
+        const std::vector<uint32_t>& expected = network.get_step_spikes();
+        const auto& spikes = compiled.get_step_spikes();
+        assert(std::vector<uint32_t>(spikes.begin(), spikes.end()) == expected);
+        for (uint32_t i : expected) {
+            if (i >= 35) ++output_spikes;
+        }
+    }
+    assert(output_spikes > 50);
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
+void test_bulk_connect() {
+    std::cout << "Test 13: Bulk Connect Matches a connect() Loop\n";
+    
+    Network bulk(30), looped(30);
+    TestRandom bulk_random(23), loop_random(23);
+    auto draw = [&bulk_random](uint32_t, uint32_t) { return bulk_random.uniform(0.0, 1.0); };
+    
+    // Overlapping ranges (self-connections skipped), first into empty rows,
+    // then over existing synapses; then pairs with repeats, a self-connection
+    // and out-of-range neurons
+    bulk.connect_dense(0, 20, 10, 30, draw);
+    bulk.connect_dense(5, 15, 0, 40, draw);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs = {{3, 3}, {2, 40}, {25, 1}, {1, 12}, {40, 2}, {29, 0}};
+    bulk.connect_sparse(pairs, draw);
+    
+    for (size_t from = 0; from < 20; ++from) {
+        for (size_t to = 10; to < 30; ++to) looped.connect(from, to, loop_random.uniform(0.0, 1.0));
+    }
+    for (size_t from = 5; from < 15; ++from) {
+        for (size_t to = 0; to < 30; ++to) looped.connect(from, to, loop_random.uniform(0.0, 1.0));
+    }
+    for (const std::pair<uint32_t, uint32_t>& pair : pairs) {
+        looped.connect(pair.first, pair.second, loop_random.uniform(0.0, 1.0));
+    }
+    
+    const SynapseStore& a = bulk.get_synapses();
+    const SynapseStore& b = looped.get_synapses();
+    assert(a.size() == b.size());
+    assert(a.size() == 390 + 95 + 2); // First block, new rows 5..14 -> 0..9, (25, 1) and (29, 0)
+    for (size_t i = 0; i <= 30; ++i) {
+        assert(a.offsets_data()[i] == b.offsets_data()[i]);
+    }
+    for (size_t k = 0; k < a.size(); ++k) {
+        assert(a.targets_data()[k] == b.targets_data()[k]);
+        assert(a.weights_data()[k] == b.weights_data()[k]);
+    }
+    
+    std::cout << "  ✓ Passed\n\n";
+}
+
 int main() {
     std::cout << "=== Running Functionality Tests ===\n\n";
     
@@ -171,6 +516,14 @@ int main() {
         test_network_basic();
         test_network_propagation();
         test_sustained_input();
+        test_engine_equivalence();
+        test_reset_and_snapshot();
+        test_stdp_reference();
+        test_stdp_pooled();
+        test_learning_state();
+        test_simulation_state();
+        test_static_network();
+        test_bulk_connect();
         
         std::cout << "=== All Tests Passed! ===\n";
         return 0;
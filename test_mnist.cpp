@@ -1,4 +1,10 @@
 #include "network.h"
+#include "compiled_network.h"
+#include "quantized_network.h"
+#include "batched_network.h"
+#include "static_network.h"
+#include "model.h"
+#include "thread_pool.h"
 #include "load_mnist.cpp"
 #include <iostream>
 #include <fstream>
@@ -9,7 +15,8 @@
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
-#include <map>
+#include <memory>
+#include <chrono>
 
 // MNIST Test Program - Tests trained network on MNIST test data
 
@@ -67,73 +74,137 @@ Network* recreate_network(const NetworkArchitecture& arch) {
     std::mt19937 gen(rd());
     std::uniform_real_distribution<> weight_dist(0.1, 0.3);
     
-    // Connect input to first hidden layer
-    for (int i = 0; i < arch.input_size; ++i) {
-        for (int j = 0; j < arch.hidden_sizes[0]; ++j) {
-            network->connect(i, arch.input_size + j, weight_dist(gen));
-        }
+    // Fully connect each layer to the next, one bulk call per layer
+    std::vector<int> layer_sizes(1, arch.input_size);
+    layer_sizes.insert(layer_sizes.end(), arch.hidden_sizes.begin(), arch.hidden_sizes.end());
+    layer_sizes.push_back(arch.output_size);
+    
+    auto random_weight = [&](size_t, size_t) { return weight_dist(gen); };
+    int layer_start = 0;
+    for (size_t layer = 0; layer + 1 < layer_sizes.size(); ++layer) {
+        int next_start = layer_start + layer_sizes[layer];
+        network->connect_dense(layer_start, next_start, next_start,
+                               next_start + layer_sizes[layer + 1], random_weight);
+        layer_start = next_start;
     }
     
-    // Connect hidden layers
-    for (size_t layer = 0; layer < arch.hidden_sizes.size() - 1; ++layer) {
-        int current_layer_start = arch.input_size;
-        for (size_t i = 0; i < layer; ++i) {
-            current_layer_start += arch.hidden_sizes[i];
-        }
-        int current_layer_end = current_layer_start + arch.hidden_sizes[layer];
-        int next_layer_start = arch.input_size;
-        for (size_t i = 0; i <= layer; ++i) {
-            next_layer_start += arch.hidden_sizes[i];
-        }
-        
-        for (int i = current_layer_start; i < current_layer_end; ++i) {
-            for (int j = 0; j < arch.hidden_sizes[layer + 1]; ++j) {
-                network->connect(i, next_layer_start + j, weight_dist(gen));
-            }
-        }
+    return network;
+}
+
+// Apply the rate-coded image as input current
+void apply_image(Network& network, const std::vector<double>& image, int input_size) {
+    for (size_t i = 0; i < image.size() && i < (size_t)input_size; ++i) {
+        network.get_neuron(i)->apply_input(image[i] * 2.0);
     }
-    
-    // Connect last hidden layer to output
-    int last_hidden_start = arch.input_size;
-    for (size_t i = 0; i < arch.hidden_sizes.size() - 1; ++i) {
-        last_hidden_start += arch.hidden_sizes[i];
+}
+
+template <typename Scalar>
+void apply_image(CompiledNetwork<Scalar>& network, const std::vector<double>& image, int input_size) {
+    for (size_t i = 0; i < image.size() && i < (size_t)input_size; ++i) {
+        network.apply_input(i, image[i] * 2.0);
     }
-    int last_hidden_end = last_hidden_start + arch.hidden_sizes.back();
-    int output_start = arch.get_output_start();
-    
-    for (int i = last_hidden_start; i < last_hidden_end; ++i) {
-        for (int j = 0; j < arch.output_size; ++j) {
-            network->connect(i, output_start + j, weight_dist(gen));
-        }
+}
+
+template <int... Sizes>
+void apply_image(StaticNetwork<Sizes...>& network, const std::vector<double>& image, int input_size) {
+    for (size_t i = 0; i < image.size() && i < (size_t)input_size; ++i) {
+        network.apply_input(i, image[i] * 2.0);
     }
+}
+
+void apply_image(SimulationState& network, const std::vector<double>& image, int input_size) {
+    for (size_t i = 0; i < image.size() && i < (size_t)input_size; ++i) {
+        network.apply_input(i, image[i] * 2.0);
+    }
+}
+
+void apply_image(QuantizedNetwork& network, const std::vector<double>& image, int input_size) {
+    for (size_t i = 0; i < image.size() && i < (size_t)input_size; ++i) {
+        network.apply_input(i, image[i] * 2.0);
+    }
+}
+
+// When predict_digit() may stop before simulation_steps
+enum class EarlyExit {
+    None,        // Always run every step
+    Settled,     // Stop once the remaining steps cannot change the prediction
+    Margin,      // Stop once the leading output is margin spikes ahead
+    FirstSpike   // Stop at the first step with an output spike
+};
+
+struct EarlyExitRule {
+    EarlyExit mode;
+    int margin;  // Lead required by EarlyExit::Margin
     
-    return network;
+    EarlyExitRule() : mode(EarlyExit::None), margin(3) {}
+};
+
+// True if the prediction from output_spikes should be taken now, with
+// remaining_steps steps still to run
+bool should_exit_early(const std::vector<int>& output_spikes, int remaining_steps,
+                       const EarlyExitRule& rule) {
+    if (rule.mode == EarlyExit::None) return false;
+    
+    int leader = 0;
+    for (size_t i = 1; i < output_spikes.size(); ++i) {
+        if (output_spikes[i] > output_spikes[leader]) leader = (int)i;
+    }
+    int runner_up = 0;
+    for (size_t i = 0; i < output_spikes.size(); ++i) {
+        if ((int)i != leader) runner_up = std::max(runner_up, output_spikes[i]);
+    }
+    const int lead = output_spikes[leader] - runner_up;
+    
+    switch (rule.mode) {
+        case EarlyExit::Settled:
+            // An output spikes at most once per step, so no other output can
+            // catch up (ties go to the lowest index, hence strictly more)
+            return lead > remaining_steps;
+        case EarlyExit::Margin:
+            return output_spikes[leader] > 0 && lead >= rule.margin;
+        case EarlyExit::FirstSpike:
+            return output_spikes[leader] > 0;
+        default:
+            return false;
+    }
 }
 
-int predict_digit(Network& network, const NetworkArchitecture& arch, 
-                  const std::vector<double>& image, int simulation_steps = 30) {
+// Works with the reference Network and with the float, fixed-point and static
+// engines. Stops early according to rule; steps_used (if given) receives the
+// number of steps simulated.
+template <typename Net>
+int predict_digit(Net& network, const NetworkArchitecture& arch, 
+                  const std::vector<double>& image, int simulation_steps = 30,
+                  const EarlyExitRule& rule = EarlyExitRule(), int* steps_used = nullptr) {
     network.reset();
     
     // Apply input (rate coding)
-    for (size_t i = 0; i < image.size() && i < (size_t)arch.input_size; ++i) {
-        double input_current = image[i] * 2.0;
-        network.get_neuron(i)->apply_input(input_current);
-    }
+    apply_image(network, image, arch.input_size);
     
     // Run simulation
     std::vector<int> output_spikes(arch.output_size, 0);
     int output_start = arch.get_output_start();
     
-    for (int step = 0; step < simulation_steps; ++step) {
+    int step = 0;
+    while (step < simulation_steps) {
         network.update();
         
-        // Count spikes in output layer
-        for (int i = 0; i < arch.output_size; ++i) {
-            int neuron_idx = output_start + i;
-            if (network.get_neuron(neuron_idx)->spiked()) {
-                output_spikes[i]++;
+        // Count spikes in output layer (step spikes are in ascending order)
+        const auto& spikes = network.get_step_spikes();
+        auto first = std::lower_bound(spikes.begin(), spikes.end(), (uint32_t)output_start);
+        for (auto it = first; it != spikes.end(); ++it) {
+            int output = (int)*it - output_start;
+            if (output < arch.output_size) {
+                output_spikes[output]++;
             }
         }
+        ++step;
+        if (should_exit_early(output_spikes, simulation_steps - step, rule)) {
+            break;
+        }
+    }
+    if (steps_used) {
+        *steps_used = step;
     }
     
     // Find prediction (neuron with most spikes)
@@ -149,6 +220,143 @@ int predict_digit(Network& network, const NetworkArchitecture& arch,
     return predicted;
 }
 
+// Predict samples [begin, begin + count) at once, one per batch lane. Lane
+// results match predict_digit() on the time-driven double network.
+void predict_batch(BatchedNetwork& network, const NetworkArchitecture& arch,
+                   const std::vector<MNISTLoader::Sample>& samples, size_t begin, size_t count,
+                   int simulation_steps, std::vector<int>& predictions) {
+    network.reset();
+    for (size_t lane = 0; lane < count; ++lane) {
+        const std::vector<double>& image = samples[begin + lane].data;
+        for (size_t i = 0; i < image.size() && i < (size_t)arch.input_size; ++i) {
+            network.apply_input(lane, i, image[i] * 2.0);
+        }
+    }
+    for (int step = 0; step < simulation_steps; ++step) {
+        network.update();
+    }
+    
+    // Output spike counts accumulate from reset, so they equal the per-step sums
+    const int output_start = arch.get_output_start();
+    for (size_t lane = 0; lane < count; ++lane) {
+        int predicted = 0;
+        int max_spikes = network.get_spike_count(lane, output_start);
+        for (int i = 1; i < arch.output_size; ++i) {
+            if (network.get_spike_count(lane, output_start + i) > max_spikes) {
+                max_spikes = network.get_spike_count(lane, output_start + i);
+                predicted = i;
+            }
+        }
+        predictions[begin + lane] = predicted;
+    }
+}
+
+const int NUM_DIGITS = 10;
+
+// Accuracy counters of one evaluation worker, merged when all are done
+struct EvaluationStats {
+    int correct;
+    long steps;                                   // Simulation steps used
+    int digit_correct[NUM_DIGITS];
+    int digit_total[NUM_DIGITS];
+    long digit_steps[NUM_DIGITS];
+    int confusion[NUM_DIGITS][NUM_DIGITS];        // [actual][predicted]
+    
+    EvaluationStats() : correct(0), steps(0) {
+        std::fill(digit_correct, digit_correct + NUM_DIGITS, 0);
+        std::fill(digit_total, digit_total + NUM_DIGITS, 0);
+        std::fill(digit_steps, digit_steps + NUM_DIGITS, 0L);
+        std::fill(&confusion[0][0], &confusion[0][0] + NUM_DIGITS * NUM_DIGITS, 0);
+    }
+    
+    void add(int actual, int predicted, int steps_used) {
+        steps += steps_used;
+        if (actual == predicted) correct++;
+        if (actual < 0 || actual >= NUM_DIGITS) return;
+        digit_total[actual]++;
+        digit_steps[actual] += steps_used;
+        if (actual == predicted) digit_correct[actual]++;
+        if (predicted >= 0 && predicted < NUM_DIGITS) confusion[actual][predicted]++;
+    }
+    
+    void merge(const EvaluationStats& other) {
+        correct += other.correct;
+        steps += other.steps;
+        for (int d = 0; d < NUM_DIGITS; ++d) {
+            digit_correct[d] += other.digit_correct[d];
+            digit_total[d] += other.digit_total[d];
+            digit_steps[d] += other.digit_steps[d];
+            for (int p = 0; p < NUM_DIGITS; ++p) {
+                confusion[d][p] += other.confusion[d][p];
+            }
+        }
+    }
+};
+
+// Predicts every sample with one engine. With num_workers > 1 the samples are
+// split into contiguous shards, one per worker thread; each worker simulates
+// on its own copy of the engine (copies share the read-only synapses) and
+// counts into its own EvaluationStats.
+struct Evaluator {
+    const NetworkArchitecture& arch;
+    const std::vector<MNISTLoader::Sample>& samples;
+    int simulation_steps;
+    const EarlyExitRule& rule;
+    size_t num_workers;
+    std::vector<int>& predictions;
+    std::vector<int>& steps_used;
+    std::vector<EvaluationStats>& stats;  // One per worker
+    std::string topology;                 // Set for a StaticNetwork, e.g. 784-400-200-10
+    
+    // Samples [begin, end) on network
+    template <typename Net>
+    void run_shard(Net& network, size_t begin, size_t end, EvaluationStats& worker_stats) {
+        for (size_t i = begin; i < end; ++i) {
+            predictions[i] = predict_digit(network, arch, samples[i].data, simulation_steps,
+                                           rule, &steps_used[i]);
+            worker_stats.add(samples[i].label, predictions[i], steps_used[i]);
+        }
+    }
+    
+    // Every sample on network itself, in order (a Network cannot be copied)
+    template <typename Net>
+    void run_sequential(Net& network) {
+        predictions.resize(samples.size());
+        steps_used.resize(samples.size());
+        stats.assign(1, EvaluationStats());
+        run_shard(network, 0, samples.size(), stats[0]);
+    }
+    
+    // Every sample on copies of prototype, one per worker
+    template <typename Net>
+    void operator()(Net& prototype) {
+        if (num_workers <= 1) {
+            run_sequential(prototype);
+            return;
+        }
+        predictions.resize(samples.size());
+        steps_used.resize(samples.size());
+        stats.assign(num_workers, EvaluationStats());
+        ThreadPool pool(num_workers);
+        auto task = [this, &prototype](size_t worker) {
+            Net network(prototype);
+            size_t begin, end;
+            ThreadPool::partition(samples.size(), num_workers, worker, begin, end);
+            run_shard(network, begin, end, stats[worker]);
+        };
+        pool.run(task);
+    }
+    
+    template <int... Sizes>
+    void operator()(StaticNetwork<Sizes...>& prototype) {
+        const int sizes[] = {Sizes...};
+        for (size_t l = 0; l < sizeof(sizes) / sizeof(sizes[0]); ++l) {
+            topology += (l > 0 ? "-" : "") + std::to_string(sizes[l]);
+        }
+        operator()<StaticNetwork<Sizes...>>(prototype);
+    }
+};
+
 int main(int argc, char* argv[]) {
     std::cout << "=== MNIST Network Testing ===\n\n";
     
@@ -158,11 +366,67 @@ int main(int argc, char* argv[]) {
     int num_test_samples = 100;
     int simulation_steps = 30;
     std::string network_file = "data/json/mnist_trained_network.json";
+    std::string engine = "time";  // time, event, two-phase
+    size_t num_threads = 1;
+    size_t num_workers = 1;  // Threads evaluating separate samples
+    bool show_samples = true;  // Print a table row for every sample
+    std::string precision = "double";  // double, float, fixed, compare
+    std::string calibration_file = "";  // Training CSV used to calibrate the fixed-point engine
+    int calibration_samples = 100;
+    size_t batch_size = 1;  // >1 simulates that many samples at once (double time/event engines)
+    bool use_static = true;  // Run known architectures on their StaticNetwork specialization
+    std::string early_exit = "none";  // none, settled, margin, first
+    EarlyExitRule exit_rule;
+    
+    // Positional arguments, plus --option=value flags anywhere on the line
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--engine=") == 0) {
+            engine = arg.substr(9);
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            num_threads = std::stoul(arg.substr(10));
+        } else if (arg.compare(0, 12, "--precision=") == 0) {
+            precision = arg.substr(12);
+        } else if (arg.compare(0, 14, "--calibration=") == 0) {
+            calibration_file = arg.substr(14);
+        } else if (arg.compare(0, 22, "--calibration-samples=") == 0) {
+            calibration_samples = std::stoi(arg.substr(22));
+        } else if (arg.compare(0, 8, "--batch=") == 0) {
+            batch_size = std::stoul(arg.substr(8));
+        } else if (arg.compare(0, 13, "--early-exit=") == 0) {
+            early_exit = arg.substr(13);
+        } else if (arg.compare(0, 14, "--exit-margin=") == 0) {
+            exit_rule.margin = std::max(1, std::stoi(arg.substr(14)));
+        } else if (arg.compare(0, 10, "--workers=") == 0) {
+            num_workers = std::max<size_t>(1, std::stoul(arg.substr(10)));
+        } else if (arg == "--quiet") {
+            show_samples = false;
+        } else if (arg == "--no-static") {
+            use_static = false;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
     
-    if (argc > 1) architecture_type = argv[1];  // simple, medium, complex
-    if (argc > 2) test_file = argv[2];          // MNIST test CSV file
-    if (argc > 3) num_test_samples = std::stoi(argv[3]);
-    if (argc > 4) simulation_steps = std::stoi(argv[4]);
+    if (args.size() > 0) architecture_type = args[0];  // simple, medium, complex
+    if (args.size() > 1) test_file = args[1];          // MNIST test CSV file
+    if (args.size() > 2) num_test_samples = std::stoi(args[2]);
+    if (args.size() > 3) simulation_steps = std::stoi(args[3]);
+    
+    if (early_exit == "settled") {
+        exit_rule.mode = EarlyExit::Settled;
+    } else if (early_exit == "margin") {
+        exit_rule.mode = EarlyExit::Margin;
+    } else if (early_exit == "first") {
+        exit_rule.mode = EarlyExit::FirstSpike;
+    } else if (early_exit != "none") {
+        std::cerr << "Unknown early-exit rule: " << early_exit << " (none, settled, margin, first)\n";
+        return 1;
+    }
     
     // Select architecture
     NetworkArchitecture arch;
@@ -219,6 +483,24 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (num_threads > 1 && engine != "two-phase") {
+        std::cout << "Note: --threads requires the two-phase engine; switching to it.\n";
+        engine = "two-phase";
+    }
+    if (engine == "event") {
+        network->set_simulation_mode(SimulationMode::EventDriven);
+    } else if (engine == "two-phase") {
+        network->set_simulation_mode(SimulationMode::TwoPhase);
+        network->set_num_threads(num_threads);
+    } else {
+        engine = "time";
+    }
+    std::cout << "Simulation engine: " << engine;
+    if (network->get_num_threads() > 1) {
+        std::cout << " (" << network->get_num_threads() << " threads)";
+    }
+    std::cout << "\n\n";
+    
     // Load test data
     std::cout << "Loading test data...\n";
     std::vector<MNISTLoader::Sample> test_data;
@@ -254,54 +536,243 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Loaded " << test_data.size() << " test samples\n\n";
     
-    // Test the network
-    std::cout << "Testing network...\n";
-    std::cout << "Simulation steps per sample: " << simulation_steps << "\n\n";
+    // The float, fixed-point and batched engines treat every synapse as
+    // delay 1, so a network with longer delays runs on the double engine
+    if (network->get_synapses().max_delay() > 1) {
+        if (precision != "double") {
+            std::cout << "Note: the network has synaptic delays up to "
+                      << network->get_synapses().max_delay()
+                      << " steps, which only the double engine models; using --precision=double.\n";
+            precision = "double";
+        }
+        if (batch_size > 1) {
+            std::cout << "Note: --batch does not model synaptic delays; running one sample at a time.\n";
+            batch_size = 1;
+        }
+    }
     
-    int correct = 0;
-    int total = test_data.size();
-    std::map<int, int> digit_correct;    // Correct predictions per digit
-    std::map<int, int> digit_total;      // Total samples per digit
-    std::map<int, std::map<int, int>> confusion_matrix;  // Confusion matrix
-    
-    // Test each sample
-    std::cout << "\nDetailed Test Results:\n";
-    std::cout << "Sample | Actual | Predicted | Result\n";
-    std::cout << "-------|--------|-----------|--------\n";
-    
-    for (size_t i = 0; i < test_data.size(); ++i) {
-        const auto& sample = test_data[i];
-        int actual = sample.label;
-        int predicted = predict_digit(*network, arch, sample.data, simulation_steps);
-        
-        digit_total[actual]++;
-        bool is_correct = (predicted == actual);
-        if (is_correct) {
-            correct++;
-            digit_correct[actual]++;
+    // The float and fixed-point engines are time-driven snapshots of the
+    // loaded weights; compare runs them next to the double reference
+    bool compare = (precision == "compare");
+    std::unique_ptr<FloatNetwork> float_network;
+    std::unique_ptr<QuantizedNetwork> fixed_network;
+    if (precision == "float" || compare) {
+        float_network.reset(new FloatNetwork(*network));
+    }
+    if (precision == "fixed" || compare) {
+        // Calibrate on training samples, never on the test set
+        std::vector<MNISTLoader::Sample> calibration_data;
+        if (!calibration_file.empty()) {
+            calibration_data = MNISTLoader::load_from_csv(calibration_file);
+        }
+        if (calibration_data.empty()) {
+            std::cout << "Calibrating fixed-point engine on synthetic samples"
+                      << " (use --calibration=mnist_train.csv for real data)\n";
+            calibration_data = MNISTLoader::generate_synthetic_mnist((calibration_samples + 9) / 10);
+        } else {
+            std::cout << "Calibrating fixed-point engine on " << calibration_file << "\n";
+        }
+        if (calibration_data.size() > (size_t)calibration_samples) {
+            calibration_data.resize(calibration_samples);
         }
         
-        confusion_matrix[actual][predicted]++;
+        std::vector<std::vector<double>> calibration_inputs;
+        for (const auto& sample : calibration_data) {
+            std::vector<double> currents(arch.input_size, 0.0);
+            for (size_t i = 0; i < sample.data.size() && i < (size_t)arch.input_size; ++i) {
+                currents[i] = sample.data[i] * 2.0;
+            }
+            calibration_inputs.push_back(currents);
+        }
+        QuantizationParams params = QuantizedNetwork::calibrate(*network, calibration_inputs, simulation_steps);
+        fixed_network.reset(new QuantizedNetwork(*network, params));
+        std::cout << "  " << calibration_inputs.size() << " samples, max potential " << params.max_potential
+                  << ", max weight " << params.max_weight << "\n";
+        std::cout << "  Format: int16 potentials with " << params.potential_bits
+                  << " fractional bits, int8 weights with " << params.weight_bits << " fractional bits\n";
+    }
+    if ((float_network || fixed_network) && engine != "time") {
+        std::cout << "Note: the float and fixed-point engines always run time-driven.\n";
+    }
+    if (!float_network && !fixed_network) {
+        precision = "double";
+    }
+    std::cout << "Precision: " << precision << "\n";
+    std::cout << "Synapse memory: " << network->connection_count() * (sizeof(uint32_t) + sizeof(double)) / 1024
+              << " KiB double";
+    if (float_network) {
+        std::cout << ", " << float_network->synapse_bytes() / 1024 << " KiB float";
+    }
+    if (fixed_network) {
+        std::cout << ", " << fixed_network->synapse_bytes() / 1024 << " KiB fixed";
+    }
+    std::cout << "\n\n";
+    
+    // Predict every sample up front; the per-sample table is printed from the
+    // predictions afterwards. Sample-parallel workers need a copyable
+    // engine, so with --workers > 1 the double network runs as one shared
+    // Model plus a SimulationState per worker (or on the static engine).
+    std::vector<int> predictions(test_data.size());
+    std::vector<int> steps_used(test_data.size(), simulation_steps);
+    std::vector<int> float_predictions;  // Compare mode
+    std::vector<int> fixed_predictions;  // Compare mode
+    std::vector<int> float_steps;        // Compare mode
+    std::vector<int> fixed_steps;        // Compare mode
+    std::vector<EvaluationStats> worker_stats;
+    std::vector<EvaluationStats> float_stats;  // Compare mode
+    std::vector<EvaluationStats> fixed_stats;  // Compare mode
+    Evaluator evaluator = {arch, test_data, simulation_steps, exit_rule, num_workers,
+                           predictions, steps_used, worker_stats, ""};
+    
+    if (num_workers > 1 && network->get_num_threads() > 1) {
+        std::cout << "Note: --threads is ignored with --workers; each worker runs the "
+                  << "two-phase engine on one thread.\n\n";
+    }
+    if (batch_size > 1 && (num_workers > 1 || exit_rule.mode != EarlyExit::None)) {
+        std::cout << "Note: --batch runs every step in one thread; ignoring it with "
+                  << "--workers or --early-exit.\n\n";
+        batch_size = 1;
+    }
+    
+    std::cout << "Testing network...\n";
+    std::cout << "Simulation steps per sample: " << simulation_steps;
+    if (exit_rule.mode != EarlyExit::None) {
+        std::cout << " (early exit: " << early_exit;
+        if (exit_rule.mode == EarlyExit::Margin) {
+            std::cout << ", margin " << exit_rule.margin;
+        }
+        std::cout << ")";
+    }
+    std::cout << "\n";
+    if (num_workers > 1) {
+        std::cout << "Evaluation workers: " << num_workers << "\n";
+    }
+    std::cout << "\n";
+    
+    auto start_time = std::chrono::steady_clock::now();
+    if (precision == "float") {
+        evaluator(*float_network);
+    } else if (precision == "fixed") {
+        evaluator(*fixed_network);
+    } else if (precision == "double" && batch_size > 1 && engine != "two-phase") {
+        // Batched inference replays the time-driven double engine, which the
+        // event-driven engine matches up to last-bit decay differences
+        BatchedNetwork batched(*network, batch_size);
+        std::cout << "Batched inference: " << batched.batch_size() << " samples at once\n\n";
+        for (size_t begin = 0; begin < test_data.size(); begin += batched.batch_size()) {
+            size_t count = std::min(batched.batch_size(), test_data.size() - begin);
+            predict_batch(batched, arch, test_data, begin, count, simulation_steps, predictions);
+        }
+        worker_stats.assign(1, EvaluationStats());
+        for (size_t i = 0; i < test_data.size(); ++i) {
+            worker_stats[0].add(test_data[i].label, predictions[i], simulation_steps);
+        }
+    } else {
+        if (batch_size > 1) {
+            std::cout << "Note: --batch needs --precision=double and the time or event engine; "
+                      << "running one sample at a time.\n\n";
+        }
         
-        // Show each test case
-        std::cout << std::setw(6) << (i + 1) << " | "
-                  << std::setw(6) << actual << " | "
-                  << std::setw(9) << predicted << " | "
-                  << (is_correct ? "✓ Correct" : "✗ Wrong") << "\n";
+        // Networks with one of the fixed MNIST architectures run on a
+        // StaticNetwork with compile-time layer sizes, which replays the
+        // time-driven double engine exactly; anything else, and the other
+        // engines, stay dynamic
+        bool done = false;
+        if (use_static && !compare && engine == "time") {
+            done = with_static_network(*network, evaluator);
+            if (done) {
+                std::cout << "Static topology: " << evaluator.topology
+                          << " (compile-time layer sizes)\n\n";
+            } else {
+                std::cout << "Static topology: none matches, using the dynamic engine\n\n";
+            }
+        }
+        if (!done && num_workers > 1) {
+            SimulationState replica(network->make_model());
+            replica.set_simulation_mode(network->get_simulation_mode());
+            replica.set_simd_level(network->get_simd_level());
+            std::cout << "Shared model: " << replica.get_model().model_bytes() / 1024
+                      << " KiB, state per worker: " << replica.state_bytes() / 1024 << " KiB\n\n";
+            evaluator(replica);
+        } else if (!done) {
+            evaluator.run_sequential(*network);
+        }
         
-        // Show progress every 10 samples
-        if ((i + 1) % 10 == 0 && (i + 1) < total) {
-            double accuracy = (double)correct / (i + 1) * 100.0;
-            std::cout << "-------|--------|-----------|--------\n";
-            std::cout << "Progress: " << (i + 1) << "/" << total 
-                      << " | Accuracy: " << std::fixed << std::setprecision(2) 
-                      << accuracy << "% (" << correct << "/" << (i + 1) << ")\n\n";
-            std::cout << "Sample | Actual | Predicted | Result\n";
-            std::cout << "-------|--------|-----------|--------\n";
+        if (compare) {
+            Evaluator float_evaluator = {arch, test_data, simulation_steps, exit_rule, num_workers,
+                                         float_predictions, float_steps, float_stats, ""};
+            float_evaluator(*float_network);
+            Evaluator fixed_evaluator = {arch, test_data, simulation_steps, exit_rule, num_workers,
+                                         fixed_predictions, fixed_steps, fixed_stats, ""};
+            fixed_evaluator(*fixed_network);
         }
     }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
     
-    std::cout << "\n";
+    EvaluationStats stats;
+    for (const EvaluationStats& worker : worker_stats) {
+        stats.merge(worker);
+    }
+    
+    int total = test_data.size();
+    int correct = stats.correct;
+    int float_correct = 0;         // Compare mode: float engine results
+    int float_disagreements = 0;   // Compare mode: float and double predictions differ
+    int fixed_correct = 0;         // Compare mode: fixed-point engine results
+    int fixed_disagreements = 0;   // Compare mode: fixed-point and double predictions differ
+    long float_total_steps = 0;    // Compare mode: simulation steps of each engine
+    long fixed_total_steps = 0;
+    if (compare) {
+        for (size_t i = 0; i < test_data.size(); ++i) {
+            if (float_predictions[i] == test_data[i].label) float_correct++;
+            if (float_predictions[i] != predictions[i]) float_disagreements++;
+            if (fixed_predictions[i] == test_data[i].label) fixed_correct++;
+            if (fixed_predictions[i] != predictions[i]) fixed_disagreements++;
+        }
+        for (const EvaluationStats& worker : float_stats) float_total_steps += worker.steps;
+        for (const EvaluationStats& worker : fixed_stats) fixed_total_steps += worker.steps;
+    }
+    
+    if (show_samples) {
+        std::cout << "\nDetailed Test Results:\n";
+        std::cout << "Sample | Actual | Predicted | Result\n";
+        std::cout << "-------|--------|-----------|--------\n";
+        
+        int running_correct = 0;
+        for (size_t i = 0; i < test_data.size(); ++i) {
+            int actual = test_data[i].label;
+            int predicted = predictions[i];
+            bool is_correct = (predicted == actual);
+            if (is_correct) running_correct++;
+            
+            std::cout << std::setw(6) << (i + 1) << " | "
+                      << std::setw(6) << actual << " | "
+                      << std::setw(9) << predicted << " | "
+                      << (is_correct ? "✓ Correct" : "✗ Wrong");
+            if (compare && float_predictions[i] != predicted) {
+                std::cout << " (float: " << float_predictions[i] << ")";
+            }
+            if (compare && fixed_predictions[i] != predicted) {
+                std::cout << " (fixed: " << fixed_predictions[i] << ")";
+            }
+            if (steps_used[i] < simulation_steps) {
+                std::cout << " [" << steps_used[i] << " steps]";
+            }
+            std::cout << "\n";
+            
+            // Show progress every 10 samples
+            if ((i + 1) % 10 == 0 && (int)(i + 1) < total) {
+                double accuracy = (double)running_correct / (i + 1) * 100.0;
+                std::cout << "-------|--------|-----------|--------\n";
+                std::cout << "Progress: " << (i + 1) << "/" << total 
+                          << " | Accuracy: " << std::fixed << std::setprecision(2) 
+                          << accuracy << "% (" << running_correct << "/" << (i + 1) << ")\n\n";
+                std::cout << "Sample | Actual | Predicted | Result\n";
+                std::cout << "-------|--------|-----------|--------\n";
+            }
+        }
+        std::cout << "\n";
+    }
     
     // Print results
     std::cout << "\n=== Test Results ===\n";
@@ -311,21 +782,53 @@ int main(int argc, char* argv[]) {
     
     double overall_accuracy = (double)correct / total * 100.0;
     std::cout << "\nOverall Accuracy: " << std::fixed << std::setprecision(2) 
-              << overall_accuracy << "% (" << correct << "/" << total << ")\n\n";
+              << overall_accuracy << "% (" << correct << "/" << total << ")\n";
+    double average_steps = (double)stats.steps / total;
+    std::cout << "Average simulation steps: " << average_steps << " of " << simulation_steps;
+    if (exit_rule.mode != EarlyExit::None) {
+        std::cout << " (" << simulation_steps / average_steps << "x fewer)";
+    }
+    std::cout << "\n";
+    std::cout << "Evaluation time: " << std::setprecision(3) << elapsed.count() << " s ("
+              << std::setprecision(1) << total / elapsed.count() << " samples/s)\n\n"
+              << std::setprecision(2);
+    
+    if (compare) {
+        // Accuracy drift of the reduced-precision engines against the double reference
+        double float_accuracy = (double)float_correct / total * 100.0;
+        double fixed_accuracy = (double)fixed_correct / total * 100.0;
+        std::cout << "Precision Comparison (vs double):\n";
+        std::cout << "Engine | Accuracy | Drift        | Disagreements | Avg steps\n";
+        std::cout << "-------|----------|--------------|---------------|----------\n";
+        std::cout << "double | " << std::setw(7) << overall_accuracy << "% |            - |             - | "
+                  << std::setw(9) << average_steps << "\n";
+        std::cout << "float  | " << std::setw(7) << float_accuracy << "% | "
+                  << std::showpos << std::setw(6) << (float_accuracy - overall_accuracy) << std::noshowpos
+                  << " points | " << std::setw(13)
+                  << (std::to_string(float_disagreements) + "/" + std::to_string(total)) << " | "
+                  << std::setw(9) << (double)float_total_steps / total << "\n";
+        std::cout << "fixed  | " << std::setw(7) << fixed_accuracy << "% | "
+                  << std::showpos << std::setw(6) << (fixed_accuracy - overall_accuracy) << std::noshowpos
+                  << " points | " << std::setw(13)
+                  << (std::to_string(fixed_disagreements) + "/" + std::to_string(total)) << " | "
+                  << std::setw(9) << (double)fixed_total_steps / total << "\n\n";
+    }
     
     // Per-digit accuracy
     std::cout << "Per-Digit Accuracy:\n";
-    std::cout << "Digit | Correct | Total | Accuracy\n";
-    std::cout << "------|---------|-------|----------\n";
-    for (int digit = 0; digit < 10; ++digit) {
-        int correct_count = digit_correct[digit];
-        int total_count = digit_total[digit];
+    std::cout << "Digit | Correct | Total | Accuracy | Avg steps\n";
+    std::cout << "------|---------|-------|----------|----------\n";
+    for (int digit = 0; digit < NUM_DIGITS; ++digit) {
+        int correct_count = stats.digit_correct[digit];
+        int total_count = stats.digit_total[digit];
         double accuracy = (total_count > 0) ? (double)correct_count / total_count * 100.0 : 0.0;
+        double steps = (total_count > 0) ? (double)stats.digit_steps[digit] / total_count : 0.0;
         
         std::cout << std::setw(5) << digit << " | "
                   << std::setw(7) << correct_count << " | "
                   << std::setw(5) << total_count << " | "
-                  << std::fixed << std::setprecision(2) << accuracy << "%\n";
+                  << std::fixed << std::setprecision(2) << std::setw(7) << accuracy << "% | "
+                  << std::setw(9) << steps << "\n";
     }
     
     // Confusion matrix
@@ -341,10 +844,10 @@ int main(int argc, char* argv[]) {
     }
     std::cout << "\n";
     
-    for (int actual = 0; actual < 10; ++actual) {
+    for (int actual = 0; actual < NUM_DIGITS; ++actual) {
         std::cout << std::setw(4) << actual << " |";
-        for (int predicted = 0; predicted < 10; ++predicted) {
-            int count = confusion_matrix[actual][predicted];
+        for (int predicted = 0; predicted < NUM_DIGITS; ++predicted) {
+            int count = stats.confusion[actual][predicted];
             if (actual == predicted && count > 0) {
                 std::cout << std::setw(4) << "✓" << count;
             } else if (count > 0) {
@@ -360,11 +863,9 @@ int main(int argc, char* argv[]) {
     std::cout << "\nMost Common Errors:\n";
     std::vector<std::tuple<int, int, int>> errors;  // (actual, predicted, count)
     
-    for (const auto& actual_pair : confusion_matrix) {
-        int actual = actual_pair.first;
-        for (const auto& pred_pair : actual_pair.second) {
-            int predicted = pred_pair.first;
-            int count = pred_pair.second;
+    for (int actual = 0; actual < NUM_DIGITS; ++actual) {
+        for (int predicted = 0; predicted < NUM_DIGITS; ++predicted) {
+            int count = stats.confusion[actual][predicted];
             if (actual != predicted && count > 0) {
                 errors.push_back(std::make_tuple(actual, predicted, count));
             }
@@ -0,0 +1,67 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t num_workers)
+    : current_fn(nullptr), current_task(nullptr),
+      generation(0), remaining(0), stopping(false) {
+    for (size_t worker = 1; worker < num_workers; ++worker) {
+        threads.emplace_back(&ThreadPool::worker_loop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::dispatch(TaskFn fn, void* task) {
+    if (threads.empty()) {
+        fn(task, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_fn = fn;
+        current_task = task;
+        remaining = threads.size();
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    // The calling thread is worker 0
+    fn(task, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return remaining == 0; });
+}
+
+void ThreadPool::worker_loop(size_t worker) {
+    size_t seen_generation = 0;
+    for (;;) {
+        TaskFn fn;
+        void* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [this, seen_generation] {
+                return stopping || generation != seen_generation;
+            });
+            if (stopping) return;
+            seen_generation = generation;
+            fn = current_fn;
+            task = current_task;
+        }
+
+        fn(task, worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Fixed-size pool that runs the same task on every worker and waits for all
+// of them (a fork/join barrier). The calling thread acts as worker 0, so a
+// pool of size 1 starts no threads at all. Dispatch does not allocate, which
+// keeps it usable inside the per-step simulation loop.
+class ThreadPool {
+public:
+    // Create a pool with num_workers workers in total (including the caller)
+    explicit ThreadPool(size_t num_workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers (including the calling thread)
+    size_t size() const { return threads.size() + 1; }
+
+    // Call task(worker) once on every worker, worker in [0, size()), and
+    // return when all calls have finished
+    template <typename Task>
+    void run(Task& task) {
+        dispatch(&invoke<Task>, &task);
+    }
+
+    // Split [0, count) into `workers` contiguous ranges and return the range
+    // [begin, end) belonging to `worker`
+    static void partition(size_t count, size_t workers, size_t worker,
+                          size_t& begin, size_t& end) {
+        begin = count * worker / workers;
+        end = count * (worker + 1) / workers;
+    }
+
+private:
+    typedef void (*TaskFn)(void*, size_t);
+
+    template <typename Task>
+    static void invoke(void* task, size_t worker) {
+        (*static_cast<Task*>(task))(worker);
+    }
+
+    void dispatch(TaskFn fn, void* task);
+    void worker_loop(size_t worker);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    TaskFn current_fn;
+    void* current_task;
+    size_t generation;   // Incremented for every dispatched task
+    size_t remaining;    // Workers still running the current task
+    bool stopping;
+};
+
+#endif // THREAD_POOL_H
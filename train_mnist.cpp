@@ -1,4 +1,7 @@
 #include "network.h"
+#include "batched_network.h"
+#include "learning_state.h"
+#include "thread_pool.h"
 #include "load_mnist.cpp"
 #include <iostream>
 #include <fstream>
@@ -9,6 +12,9 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
 
 // MNIST Training Program for Spike Neural Network
 // Recommended architectures:
@@ -66,51 +72,76 @@ NetworkArchitecture create_complex_architecture() {
 
 void build_network(Network& network, const NetworkArchitecture& arch, 
                    std::mt19937& gen, std::uniform_real_distribution<>& weight_dist) {
-    // Connect input to first hidden layer
-    for (int i = 0; i < arch.input_size; ++i) {
-        for (int j = 0; j < arch.hidden_sizes[0]; ++j) {
-            network.connect(i, arch.input_size + j, weight_dist(gen));
-        }
-    }
+    // Fully connect each layer to the next: input -> hidden layers -> output.
+    // Whole layers go in with one bulk call each, straight into the synapse
+    // store; weights are drawn in the same order as connecting edge by edge.
+    std::vector<int> layer_sizes(1, arch.input_size);
+    layer_sizes.insert(layer_sizes.end(), arch.hidden_sizes.begin(), arch.hidden_sizes.end());
+    layer_sizes.push_back(arch.output_size);
     
-    // Connect hidden layers
-    for (size_t layer = 0; layer < arch.hidden_sizes.size() - 1; ++layer) {
-        // Calculate start and end indices for current layer
-        int current_layer_start = arch.input_size;
-        for (size_t i = 0; i < layer; ++i) {
-            current_layer_start += arch.hidden_sizes[i];
-        }
-        int current_layer_end = current_layer_start + arch.hidden_sizes[layer];
-        
-        // Calculate start index for next layer
-        int next_layer_start = arch.input_size;
-        for (size_t i = 0; i <= layer; ++i) {
-            next_layer_start += arch.hidden_sizes[i];
-        }
-        
-        // Connect current layer to next layer
-        for (int i = current_layer_start; i < current_layer_end; ++i) {
-            for (int j = 0; j < arch.hidden_sizes[layer + 1]; ++j) {
-                network.connect(i, next_layer_start + j, weight_dist(gen));
-            }
-        }
+    auto random_weight = [&](size_t, size_t) { return weight_dist(gen); };
+    int layer_start = 0;
+    for (size_t layer = 0; layer + 1 < layer_sizes.size(); ++layer) {
+        int next_start = layer_start + layer_sizes[layer];
+        network.connect_dense(layer_start, next_start, next_start,
+                              next_start + layer_sizes[layer + 1], random_weight);
+        layer_start = next_start;
     }
-    
-    // Connect last hidden layer to output
-    int last_hidden_start = arch.input_size;
-    for (size_t i = 0; i < arch.hidden_sizes.size() - 1; ++i) {
-        last_hidden_start += arch.hidden_sizes[i];
-    }
-    int last_hidden_end = last_hidden_start + arch.hidden_sizes.back();
+}
+
+// Training-set accuracy of the current weights, with learning frozen. Runs
+// batch_size samples at once on a time-driven snapshot of the network.
+double evaluate_accuracy(const Network& network, const NetworkArchitecture& arch,
+                         const std::vector<MNISTLoader::Sample>& samples, size_t batch_size,
+                         int simulation_steps) {
+    BatchedNetwork batched(network, batch_size);
     int output_start = arch.input_size;
     for (int h : arch.hidden_sizes) {
         output_start += h;
     }
     
-    for (int i = last_hidden_start; i < last_hidden_end; ++i) {
-        for (int j = 0; j < arch.output_size; ++j) {
-            network.connect(i, output_start + j, weight_dist(gen));
+    int correct = 0;
+    for (size_t begin = 0; begin < samples.size(); begin += batched.batch_size()) {
+        size_t count = std::min(batched.batch_size(), samples.size() - begin);
+        batched.reset();
+        for (size_t lane = 0; lane < count; ++lane) {
+            const std::vector<double>& image = samples[begin + lane].data;
+            for (size_t i = 0; i < image.size() && i < (size_t)arch.input_size; ++i) {
+                batched.apply_input(lane, i, image[i] * 2.0);
+            }
+        }
+        for (int step = 0; step < simulation_steps; ++step) {
+            batched.update();
         }
+        for (size_t lane = 0; lane < count; ++lane) {
+            int predicted = 0;
+            for (int i = 1; i < arch.output_size; ++i) {
+                if (batched.get_spike_count(lane, output_start + i) >
+                    batched.get_spike_count(lane, output_start + predicted)) {
+                    predicted = i;
+                }
+            }
+            if (predicted == samples[begin + lane].label) correct++;
+        }
+    }
+    return (double)correct / samples.size() * 100.0;
+}
+
+// Prediction (the output with the most spikes, lowest index on a tie) and
+// squared error of one sample's output spike counts
+void score_sample(const std::vector<int>& output_spikes, int label, int simulation_steps,
+                  int& predicted, double& loss) {
+    predicted = 0;
+    for (size_t i = 1; i < output_spikes.size(); ++i) {
+        if (output_spikes[i] > output_spikes[predicted]) {
+            predicted = (int)i;
+        }
+    }
+    loss = 0.0;
+    for (size_t i = 0; i < output_spikes.size(); ++i) {
+        double target = ((int)i == label) ? 1.0 : 0.0;
+        double actual = (double)output_spikes[i] / simulation_steps;
+        loss += (target - actual) * (target - actual);
     }
 }
 
@@ -122,11 +153,40 @@ int main(int argc, char* argv[]) {
     double learning_rate = 0.01;
     int epochs = 5;
     std::string mnist_file = "";  // CSV file path, empty = use synthetic
+    size_t num_threads = 1;       // >1 uses the parallel two-phase engine
+    size_t eval_batch = 0;        // >0 re-evaluates training accuracy after each epoch
+    size_t num_workers = 1;       // >1 trains on separate samples in parallel (Hogwild)
+    size_t merge_every = 0;       // >0 defers weight changes, merged every N samples
+    bool seeded = false;          // Fixed seed for weights and sample order
+    unsigned seed = 0;
     
-    if (argc > 1) architecture_type = argv[1];
-    if (argc > 2) learning_rate = std::stod(argv[2]);
-    if (argc > 3) epochs = std::stoi(argv[3]);
-    if (argc > 4) mnist_file = argv[4];
+    // Positional arguments, plus --option=value flags anywhere on the line
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--threads=") == 0) {
+            num_threads = std::stoul(arg.substr(10));
+        } else if (arg.compare(0, 10, "--workers=") == 0) {
+            num_workers = std::max<size_t>(1, std::stoul(arg.substr(10)));
+        } else if (arg.compare(0, 14, "--merge-every=") == 0) {
+            merge_every = std::stoul(arg.substr(14));
+        } else if (arg.compare(0, 7, "--seed=") == 0) {
+            seed = (unsigned)std::stoul(arg.substr(7));
+            seeded = true;
+        } else if (arg.compare(0, 13, "--eval-batch=") == 0) {
+            eval_batch = std::stoul(arg.substr(13));
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    if (args.size() > 0) architecture_type = args[0];
+    if (args.size() > 1) learning_rate = std::stod(args[1]);
+    if (args.size() > 2) epochs = std::stoi(args[2]);
+    if (args.size() > 3) mnist_file = args[3];
     
     // Select architecture
     NetworkArchitecture arch;
@@ -152,11 +212,23 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Creating network connections...\n";
     std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seeded ? seed : rd());
     std::uniform_real_distribution<> weight_dist(0.05, 0.15);  // Smaller weights for larger network
     
     build_network(network, arch, gen, weight_dist);
     
+    if ((num_workers > 1 || merge_every > 0) && num_threads > 1) {
+        std::cout << "Note: --threads is ignored with --workers; each worker runs the "
+                  << "time-driven engine on one thread\n";
+        num_threads = 1;
+    }
+    if (num_threads > 1) {
+        // Parallel stepping needs the order-independent two-phase engine
+        network.set_simulation_mode(SimulationMode::TwoPhase);
+        network.set_num_threads(num_threads);
+        std::cout << "Using two-phase engine with " << num_threads << " threads\n";
+    }
+    
     // Calculate total connections
     int total_connections = 0;
     total_connections += arch.input_size * arch.hidden_sizes[0];
@@ -204,9 +276,42 @@ int main(int argc, char* argv[]) {
     std::cout << "Starting training...\n";
     std::cout << "Epochs: " << epochs << ", Learning rate: " << learning_rate << "\n\n";
     
+    int output_start = arch.input_size;
+    for (int h : arch.hidden_sizes) {
+        output_start += h;
+    }
+    const int simulation_steps = 30;  // More steps for larger network
+    
+    // Hogwild training: every worker presents its own samples on its own
+    // neuron state, and all of them apply STDP to the network's weights in
+    // place without locking. With --merge-every, workers collect their
+    // changes privately instead, and the changes are merged after every
+    // round of merge_every samples. --workers=1 without it keeps the
+    // sequential loop.
+    std::unique_ptr<ThreadPool> worker_pool;
+    std::vector<std::unique_ptr<LearningState>> learners;
+    std::vector<LearningState*> learner_list;
+    if (num_workers > 1 || merge_every > 0) {
+        if (num_workers > 1) worker_pool.reset(new ThreadPool(num_workers));
+        for (size_t w = 0; w < num_workers; ++w) {
+            learners.emplace_back(new LearningState(network));
+            learners.back()->set_deferred(merge_every > 0);
+            learner_list.push_back(learners.back().get());
+        }
+        if (merge_every > 0) {
+            std::cout << "Deferred training on " << num_workers << " worker(s), merging every "
+                      << merge_every << " samples\n\n";
+        } else {
+            std::cout << "Hogwild training on " << num_workers << " workers (shared weights)\n\n";
+        }
+    }
+    std::vector<int> predictions(training_data.size());
+    std::vector<double> losses(training_data.size());
+    
     for (int epoch = 0; epoch < epochs; ++epoch) {
         std::cout << "=== Epoch " << (epoch + 1) << "/" << epochs << " ===\n";
         std::shuffle(training_data.begin(), training_data.end(), gen);
+        auto epoch_start = std::chrono::steady_clock::now();
         
         int correct = 0;
         double total_loss = 0.0;
@@ -215,63 +320,95 @@ int main(int argc, char* argv[]) {
         // Process in batches to show progress
         int batch_size = std::min(100, (int)training_data.size());
         
-        for (size_t sample_idx = 0; sample_idx < training_data.size(); ++sample_idx) {
-            const auto& sample = training_data[sample_idx];
-            network.reset();
+        // Samples run in rounds: a progress batch, or one merge interval
+        const size_t round_size = merge_every > 0 ? merge_every : (size_t)batch_size;
+        for (size_t batch_begin = 0; batch_begin < training_data.size(); batch_begin += round_size) {
+            const size_t batch_end = std::min(training_data.size(), batch_begin + round_size);
             
-            // Apply input (rate coding: pixel intensity -> input current)
-            for (size_t i = 0; i < sample.data.size() && i < (size_t)arch.input_size; ++i) {
-                // Convert pixel value (0-1) to input current (0-2)
-                // Higher pixel intensity = stronger input
-                double input_current = sample.data[i] * 2.0;
-                network.get_neuron(i)->apply_input(input_current);
-            }
-            
-            // Run simulation
-            int simulation_steps = 30;  // More steps for larger network
-            std::vector<int> output_spikes(arch.output_size, 0);
-            
-            for (int step = 0; step < simulation_steps; ++step) {
-                network.update_with_learning(step, learning_rate);
-                
-                // Count spikes in output layer
-                int output_start = arch.input_size;
-                for (int h : arch.hidden_sizes) {
-                    output_start += h;
-                }
-                
-                for (int i = 0; i < arch.output_size; ++i) {
-                    int neuron_idx = output_start + i;
-                    if (network.get_neuron(neuron_idx)->spiked()) {
-                        output_spikes[i]++;
+            if (!learners.empty()) {
+                // Hogwild workers take the samples of the round in turn. With
+                // deferred changes each worker gets a fixed share, so the
+                // merged weights do not depend on thread timing.
+                std::atomic<size_t> next_sample(batch_begin);
+                auto train_samples = [&](size_t worker) {
+                    LearningState& learner = *learners[worker];
+                    std::vector<int> output_spikes(arch.output_size);
+                    const bool fixed_share = merge_every > 0;
+                    size_t share_begin = 0, share_end = 0;
+                    ThreadPool::partition(batch_end - batch_begin, num_workers, worker,
+                                          share_begin, share_end);
+                    size_t own_next = batch_begin + share_begin;
+                    const size_t end = fixed_share ? batch_begin + share_end : batch_end;
+                    auto take = [&]() { return fixed_share ? own_next++ : next_sample++; };
+                    for (size_t s = take(); s < end; s = take()) {
+                        const auto& sample = training_data[s];
+                        learner.reset();
+                        for (size_t i = 0; i < sample.data.size() && i < (size_t)arch.input_size; ++i) {
+                            learner.apply_input(i, sample.data[i] * 2.0);
+                        }
+                        std::fill(output_spikes.begin(), output_spikes.end(), 0);
+                        for (int step = 0; step < simulation_steps; ++step) {
+                            learner.update_with_learning(step, learning_rate);
+                            for (int i = 0; i < arch.output_size; ++i) {
+                                if (learner.spiked(output_start + i)) output_spikes[i]++;
+                            }
+                        }
+                        score_sample(output_spikes, sample.label, simulation_steps,
+                                     predictions[s], losses[s]);
                     }
+                };
+                if (worker_pool) {
+                    worker_pool->run(train_samples);
+                } else {
+                    train_samples(0);
                 }
-            }
-            
-            // Find prediction
-            int predicted = 0;
-            int max_spikes = output_spikes[0];
-            for (int i = 1; i < arch.output_size; ++i) {
-                if (output_spikes[i] > max_spikes) {
-                    max_spikes = output_spikes[i];
-                    predicted = i;
+                if (merge_every > 0) {
+                    LearningState::merge_deferred(learner_list.data(), learner_list.size(),
+                                                  worker_pool.get());
+                }
+            } else {
+                for (size_t sample_idx = batch_begin; sample_idx < batch_end; ++sample_idx) {
+                    const auto& sample = training_data[sample_idx];
+                    network.reset();
+                    
+                    // Apply input (rate coding: pixel intensity -> input current)
+                    for (size_t i = 0; i < sample.data.size() && i < (size_t)arch.input_size; ++i) {
+                        // Convert pixel value (0-1) to input current (0-2)
+                        // Higher pixel intensity = stronger input
+                        double input_current = sample.data[i] * 2.0;
+                        network.get_neuron(i)->apply_input(input_current);
+                    }
+                    
+                    // Run simulation
+                    std::vector<int> output_spikes(arch.output_size, 0);
+                    
+                    for (int step = 0; step < simulation_steps; ++step) {
+                        network.update_with_learning(step, learning_rate);
+                        
+                        // Count spikes in output layer
+                        for (int i = 0; i < arch.output_size; ++i) {
+                            int neuron_idx = output_start + i;
+                            if (network.get_neuron(neuron_idx)->spiked()) {
+                                output_spikes[i]++;
+                            }
+                        }
+                    }
+                    
+                    score_sample(output_spikes, sample.label, simulation_steps,
+                                 predictions[sample_idx], losses[sample_idx]);
                 }
             }
             
-            if (predicted == sample.label) correct++;
-            
-            // Calculate loss
-            double loss = 0.0;
-            for (int i = 0; i < arch.output_size; ++i) {
-                double target = (i == sample.label) ? 1.0 : 0.0;
-                double actual = (double)output_spikes[i] / simulation_steps;
-                loss += (target - actual) * (target - actual);
+            int reports = 0;
+            for (size_t sample_idx = batch_begin; sample_idx < batch_end; ++sample_idx) {
+                if (predictions[sample_idx] == training_data[sample_idx].label) correct++;
+                total_loss += losses[sample_idx];
+                processed++;
+                if (processed % batch_size == 0) reports++;
             }
-            total_loss += loss;
-            processed++;
             
-            // Progress update
-            if (processed % batch_size == 0) {
+            // Progress update (once per batch_size samples)
+            if (reports > 0) {
                 double accuracy = (double)correct / processed * 100.0;
                 std::cout << "  Processed: " << processed << "/" << training_data.size()
                           << " | Accuracy: " << std::fixed << std::setprecision(2)
@@ -279,6 +416,8 @@ int main(int argc, char* argv[]) {
             }
         }
         
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       epoch_start).count();
         double accuracy = (double)correct / training_data.size() * 100.0;
         double avg_loss = total_loss / training_data.size();
         
@@ -286,7 +425,16 @@ int main(int argc, char* argv[]) {
         std::cout << "  Accuracy: " << std::fixed << std::setprecision(2) 
                   << accuracy << "% (" << correct << "/" << training_data.size() << ")\n";
         std::cout << "  Average Loss: " << std::fixed << std::setprecision(4) 
-                  << avg_loss << "\n\n";
+                  << avg_loss << "\n";
+        std::cout << "  Throughput: " << std::fixed << std::setprecision(1)
+                  << training_data.size() / seconds << " samples/sec\n";
+        if (eval_batch > 0) {
+            // The online accuracy above mixes weights from the whole epoch
+            double frozen_accuracy = evaluate_accuracy(network, arch, training_data, eval_batch, 30);
+            std::cout << "  Accuracy (end-of-epoch weights): " << std::fixed << std::setprecision(2)
+                      << frozen_accuracy << "%\n";
+        }
+        std::cout << "\n";
     }
     
     // Save trained network